@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Append only object storage. Objects are placed in chunks that never move, so references
+// stay valid until clear(); a run reserved with reserve() is contiguous.
+template <typename T>
+class arena {
+	struct chunk {
+		std::unique_ptr<std::aligned_storage_t<sizeof(T), alignof(T)>[]> storage;
+		size_t used = 0;
+		size_t capacity = 0;
+		T* at(size_t i) noexcept { return std::launder(reinterpret_cast<T*>(&storage[i])); }
+	};
+	static constexpr size_t min_chunk = 64;
+	std::list<chunk> chunks;
+	size_t count = 0;
+
+	void grow(size_t n) {
+		chunk& c = chunks.emplace_back();
+		c.capacity = std::max({ n, min_chunk, count });
+		c.storage.reset(new std::aligned_storage_t<sizeof(T), alignof(T)>[c.capacity]);
+	}
+
+public:
+	arena() = default;
+	arena(arena const&) = delete;
+	arena(arena&& r) noexcept
+		: chunks(std::move(r.chunks))
+		, count(std::exchange(r.count, 0)) {}
+	~arena() { clear(); }
+
+	arena& operator=(arena const&) = delete;
+	arena& operator=(arena&& r) noexcept {
+		clear();
+		chunks = std::move(r.chunks);
+		count = std::exchange(r.count, 0);
+		return *this;
+	}
+
+	void swap(arena& r) noexcept {
+		chunks.swap(r.chunks);
+		std::swap(count, r.count);
+	}
+
+	// Take over all objects of r, they stay where they are
+	void splice(arena&& r) noexcept {
+		chunks.splice(chunks.end(), r.chunks);
+		count += std::exchange(r.count, 0);
+	}
+
+	size_t size() const noexcept { return count; }
+
+	// Make room for n more objects in one contiguous run
+	void reserve(size_t n) {
+		if (chunks.empty() || chunks.back().capacity - chunks.back().used < n) grow(n);
+	}
+
+	// Address the next emplace_back will construct at, after reserve()
+	T* next() noexcept { return chunks.back().at(chunks.back().used); }
+
+	template <typename... Args>
+	T& emplace_back(Args&&... args) {
+		reserve(1);
+		chunk& c = chunks.back();
+		T* p = new (&c.storage[c.used]) T(std::forward<Args>(args)...);
+		c.used++;
+		count++;
+		return *p;
+	}
+
+	// Calls f(first, count) for each contiguous run of objects, in construction order
+	template <typename F>
+	void for_each_run(F&& f) {
+		for (chunk& c : chunks)
+			if (c.used) f(c.at(0), c.used);
+	}
+
+	void clear() noexcept {
+		for (auto it = chunks.rbegin(); it != chunks.rend(); ++it)
+			for (size_t i = it->used; i-- > 0;) it->at(i)->~T();
+		chunks.clear();
+		count = 0;
+	}
+};
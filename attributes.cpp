@@ -0,0 +1,36 @@
+#include "attributes.hpp"
+
+namespace graph::core
+{
+	void AttributeStore::erase(const std::string& name)
+	{
+		m_vertexColumns.erase(name);
+		m_edgeColumns.erase(name);
+	}
+
+	void AttributeStore::remap(const Relayout& moved)
+	{
+		for (auto& [name, column] : m_vertexColumns) column->remap(moved.vertexIds, m_graph.vertexIdCount());
+		for (auto& [name, column] : m_edgeColumns) column->remap(moved.edgeIds, m_graph.edgeIdCount());
+	}
+
+	std::vector<int32_t>& AttributeStore::loadWeights()
+	{
+		std::vector<int32_t>& weights = edgeColumn<int32_t>("weight");
+		for (const Vertex& vertex : m_graph.vertices())
+			vertex.forEachOutEdge([&weights](const Edge& edge) { weights[edge.id()] = edge.weight(); });
+		return weights;
+	}
+
+	void AttributeStore::storeWeights(Graph& graph)
+	{
+		if (&graph != &m_graph) throw std::invalid_argument("graph::core::AttributeStore::storeWeights: not the graph of this store");
+		const std::vector<int32_t>& weights = edgeColumn<int32_t>("weight");
+		graph.forEachEdge([&weights](Edge& edge) { edge.setWeight(weights[edge.id()]); });
+	}
+
+	VertexFunc selectMask(const Mask& mask)
+	{
+		return [&mask](const Vertex& vertex) { return vertex.id() < mask.size() && mask[vertex.id()] != 0; };
+	}
+}
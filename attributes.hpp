@@ -0,0 +1,105 @@
+#pragma once
+#include "graph.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+namespace graph::core
+{
+	// One flag per vertex or edge id
+	using Mask = std::vector<uint8_t>;
+
+	// Named attribute columns of a Graph, each a contiguous array indexed by Vertex::id() or
+	// Edge::id(). A column is created value initialized on first use and grows to the current
+	// id count whenever it is fetched; entries of removed elements are left in place.
+	class AttributeStore {
+		struct ColumnBase {
+			virtual ~ColumnBase() = default;
+			virtual void remap(const std::vector<uint32_t>& ids, size_t size) = 0;
+		};
+		template <typename T>
+		struct Column : ColumnBase {
+			std::vector<T> values;
+
+			void remap(const std::vector<uint32_t>& ids, size_t size) override {
+				std::vector<T> moved(size);
+				for (size_t i = 0; i < values.size() && i < ids.size(); i++)
+					if (ids[i] != Relayout::noId) moved[ids[i]] = std::move(values[i]);
+				values = std::move(moved);
+			}
+		};
+		using Columns = std::map<std::string, std::unique_ptr<ColumnBase>>;
+
+		const Graph& m_graph;
+		Columns m_vertexColumns;
+		Columns m_edgeColumns;
+
+		template <typename T>
+		static std::vector<T>& fetch(Columns& columns, const std::string& name, size_t size) {
+			auto& slot = columns[name];
+			if (!slot) slot = std::make_unique<Column<T>>();
+			auto* column = dynamic_cast<Column<T>*>(slot.get());
+			if (!column) throw std::invalid_argument("graph::core::AttributeStore: column " + name + " has another type");
+			if (column->values.size() < size) column->values.resize(size);
+			return column->values;
+		}
+
+	public:
+		explicit AttributeStore(const Graph& graph)
+			: m_graph(graph) {}
+
+		// Throw std::invalid_argument if the column exists with another type
+		template <typename T>
+		std::vector<T>& vertexColumn(const std::string& name) { return fetch<T>(m_vertexColumns, name, m_graph.vertexIdCount()); }
+		template <typename T>
+		std::vector<T>& edgeColumn(const std::string& name) { return fetch<T>(m_edgeColumns, name, m_graph.edgeIdCount()); }
+
+		bool hasVertexColumn(const std::string& name) const { return m_vertexColumns.count(name) != 0; }
+		bool hasEdgeColumn(const std::string& name) const { return m_edgeColumns.count(name) != 0; }
+		void erase(const std::string& name);
+
+		// Moves every column along after the graph of the store was relaid out; entries of
+		// removed elements are dropped
+		void remap(const Relayout& moved);
+
+		// Edge column "weight" filled with Edge::weight(), and the way back after the column was
+		// recomputed. graph must be the one the store was made for, std::invalid_argument otherwise.
+		std::vector<int32_t>& loadWeights();
+		void storeWeights(Graph& graph);
+	};
+
+	// Bulk operations over whole columns. They are plain loops over contiguous data, which the
+	// compiler vectorizes for simple element functions.
+	template <typename T, typename F>
+	void transformColumn(std::vector<T>& column, F f) {
+		T* values = column.data();
+		const size_t size = column.size();
+		for (size_t i = 0; i < size; i++) values[i] = f(values[i]);
+	}
+
+	template <typename T, typename F>
+	Mask maskColumn(const std::vector<T>& column, F predicate) {
+		Mask mask(column.size());
+		const T* values = column.data();
+		uint8_t* flags = mask.data();
+		const size_t size = column.size();
+		for (size_t i = 0; i < size; i++) flags[i] = predicate(values[i]) ? 1 : 0;
+		return mask;
+	}
+
+	template <typename T, typename F>
+	T reduceColumn(const std::vector<T>& column, T init, F op) {
+		const T* values = column.data();
+		const size_t size = column.size();
+		for (size_t i = 0; i < size; i++) init = op(init, values[i]);
+		return init;
+	}
+
+	// Adapter for the VertexFunc parameters, the mask must outlive it. Vertices with ids past the
+	// end of the mask, e.g. created after it, are not selected. Edge masks are packed into a
+	// graph::alg::EdgeMask instead.
+	VertexFunc selectMask(const Mask& mask);
+}
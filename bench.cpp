@@ -0,0 +1,148 @@
+#include "graph.hpp"
+#include "graphalg.hpp"
+#include "generators.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace graph::core;
+
+namespace
+{
+	struct Options {
+		uint32_t size = 10000;
+		uint32_t degree = 3;
+		uint32_t repeat = 3;
+		uint64_t seed = 1;
+		std::string only;
+	};
+
+	struct Generator {
+		const char* name;
+		std::function<void(Graph&, const Options&, std::mt19937_64&)> build;
+	};
+
+	double seconds(const std::function<void()>& f) {
+		const auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	class Report {
+		bool first = true;
+
+	public:
+		explicit Report(const Options& options) {
+			std::cout << "{\n  \"size\": " << options.size << ",\n  \"degree\": " << options.degree
+				<< ",\n  \"repeat\": " << options.repeat << ",\n  \"seed\": " << options.seed << ",\n  \"results\": [";
+		}
+		~Report() { std::cout << "\n  ]\n}\n"; }
+		void add(const char* generator, const char* phase, size_t vertices, size_t edges, const std::vector<double>& samples) {
+			const double best = *std::min_element(samples.begin(), samples.end());
+			double mean = 0;
+			for (const double s : samples) mean += s / samples.size();
+			std::cout << (first ? "\n" : ",\n") << "    {\"generator\": \"" << generator << "\", \"phase\": \"" << phase
+				<< "\", \"vertices\": " << vertices << ", \"edges\": " << edges
+				<< ", \"min_s\": " << best << ", \"mean_s\": " << mean << "}";
+			first = false;
+		}
+	};
+
+	size_t countEdges(const Graph& graph) {
+		size_t edges = 0;
+		for (const Vertex& vertex : graph.vertices()) edges += std::distance(vertex.outEdges().begin(), vertex.outEdges().end());
+		return edges;
+	}
+
+	void run(const Generator& generator, const Options& options, Report& report) {
+		std::vector<double> build, teardown, walk, strongly, weakly, rank, loops;
+		size_t vertices = 0, edges = 0;
+		for (uint32_t r = 0; r < options.repeat; r++) {
+			std::mt19937_64 rng(options.seed + r);
+			auto graph = std::make_unique<Graph>();
+			build.push_back(seconds([&] { generator.build(*graph, options, rng); }));
+			vertices = std::distance(graph->vertices().begin(), graph->vertices().end());
+			edges = countEdges(*graph);
+
+			walk.push_back(seconds([&] {
+				size_t sum = 0;
+				for (const Vertex& vertex : graph->vertices())
+					vertex.forEachOutEdge(0, [&sum](const Edge& edge) { sum += edge.to().id(); });
+				volatile size_t sink = sum;
+				(void)sink;
+			}));
+			strongly.push_back(seconds([&] { graph::alg::strongly(*graph); }));
+			weakly.push_back(seconds([&] { graph::alg::weaklyConnected(*graph); }));
+			rank.push_back(seconds([&] { graph::alg::rank(*graph); }));
+			loops.push_back(seconds([&] {
+				uint32_t i = 0;
+				for (const Vertex& vertex : graph->vertices())
+					if (i++ % 64 == 0) graph::alg::reportLoops(vertex);
+			}));
+			teardown.push_back(seconds([&] { graph.reset(); }));
+		}
+		report.add(generator.name, "build", vertices, edges, build);
+		report.add(generator.name, "walk", vertices, edges, walk);
+		report.add(generator.name, "strongly", vertices, edges, strongly);
+		report.add(generator.name, "weaklyConnected", vertices, edges, weakly);
+		report.add(generator.name, "rank", vertices, edges, rank);
+		report.add(generator.name, "reportLoops", vertices, edges, loops);
+		report.add(generator.name, "teardown", vertices, edges, teardown);
+	}
+
+	void usage() {
+		std::cerr << "usage: bench [--size N] [--degree D] [--repeat R] [--seed S] [--only GENERATOR]\n"
+			"generators: random_dag layered power_law chains small_sccs rmat\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		const bool hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--size") && hasValue) options.size = std::strtoul(argv[++i], nullptr, 10);
+		else if (!std::strcmp(argv[i], "--degree") && hasValue) options.degree = std::strtoul(argv[++i], nullptr, 10);
+		else if (!std::strcmp(argv[i], "--repeat") && hasValue) options.repeat = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+		else if (!std::strcmp(argv[i], "--seed") && hasValue) options.seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (!std::strcmp(argv[i], "--only") && hasValue) options.only = argv[++i];
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	// The recursive algorithms need a stack about as deep as the longest path, so chains are cut every 1000 vertices
+	const std::vector<Generator> generators = {
+		{ "random_dag", [](Graph& g, const Options& o, std::mt19937_64& rng) { graph::gen::randomDag(g, o.size, o.degree, { rng() }); } },
+		{ "layered", [](Graph& g, const Options& o, std::mt19937_64& rng) {
+			const uint32_t width = std::max(1u, static_cast<uint32_t>(std::sqrt(o.size)));
+			graph::gen::layeredDag(g, o.size / width, width, o.degree, 0.8, { rng() });
+		} },
+		{ "power_law", [](Graph& g, const Options& o, std::mt19937_64& rng) { graph::gen::powerLaw(g, o.size, o.degree, { rng() }); } },
+		{ "chains", [](Graph& g, const Options& o, std::mt19937_64&) { graph::gen::chains(g, o.size, 1000); } },
+		{ "small_sccs", [](Graph& g, const Options& o, std::mt19937_64& rng) { graph::gen::plantedSccs(g, o.size, 8, o.size / 8, { rng() }); } },
+		{ "rmat", [](Graph& g, const Options& o, std::mt19937_64& rng) {
+			graph::gen::rmat(g, static_cast<uint32_t>(std::log2(std::max(2u, o.size))), uint64_t{ o.size } * o.degree, 0.57, 0.19, 0.19, { rng() });
+		} },
+	};
+
+	if (!options.only.empty() && std::none_of(generators.begin(), generators.end(), [&options](const Generator& generator) { return options.only == generator.name; })) {
+		usage();
+		return 1;
+	}
+
+	Report report(options);
+	for (const Generator& generator : generators)
+		if (options.only.empty() || options.only == generator.name) run(generator, options, report);
+	return 0;
+}
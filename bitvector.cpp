@@ -0,0 +1,53 @@
+#include "bitvector.hpp"
+
+#include <bitset>
+
+namespace graph::alg
+{
+	BitVector::BitVector(size_t bits, bool value)
+		: m_words((bits + 63) / 64, value ? ~uint64_t{ 0 } : 0)
+		, m_bits(bits)
+	{
+		if (value && bits % 64) m_words.back() &= (uint64_t{ 1 } << (bits % 64)) - 1;  // Keep the tail clear so == works
+	}
+
+	size_t BitVector::count() const
+	{
+		size_t total = 0;
+		for (const uint64_t word : m_words) total += std::bitset<64>(word).count();
+		return total;
+	}
+
+	bool BitVector::unionWith(const BitVector& rhs)
+	{
+		uint64_t changed = 0;
+		for (size_t i = 0; i < m_words.size(); i++) {
+			const uint64_t word = m_words[i] | rhs.m_words[i];
+			changed |= word ^ m_words[i];
+			m_words[i] = word;
+		}
+		return changed;
+	}
+
+	bool BitVector::intersectWith(const BitVector& rhs)
+	{
+		uint64_t changed = 0;
+		for (size_t i = 0; i < m_words.size(); i++) {
+			const uint64_t word = m_words[i] & rhs.m_words[i];
+			changed |= word ^ m_words[i];
+			m_words[i] = word;
+		}
+		return changed;
+	}
+
+	bool BitVector::assignTransfer(const BitVector& in, const BitVector& gen, const BitVector& kill)
+	{
+		uint64_t changed = 0;
+		for (size_t i = 0; i < m_words.size(); i++) {
+			const uint64_t word = gen.m_words[i] | (in.m_words[i] & ~kill.m_words[i]);
+			changed |= word ^ m_words[i];
+			m_words[i] = word;
+		}
+		return changed;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace graph::alg
+{
+	// Fixed size set of bits, word loops are kept branch free so the compiler can vectorize them
+	class BitVector {
+		std::vector<uint64_t> m_words;
+		size_t m_bits = 0;
+
+	public:
+		BitVector() = default;
+		explicit BitVector(size_t bits, bool value = false);
+		size_t size() const { return m_bits; }
+		bool test(size_t bit) const { return (m_words[bit / 64] >> (bit % 64)) & 1; }
+		void set(size_t bit) { m_words[bit / 64] |= uint64_t{ 1 } << (bit % 64); }
+		void reset(size_t bit) { m_words[bit / 64] &= ~(uint64_t{ 1 } << (bit % 64)); }
+		size_t count() const;
+		bool operator==(const BitVector& rhs) const { return m_words == rhs.m_words; }
+		bool operator!=(const BitVector& rhs) const { return m_words != rhs.m_words; }
+
+		// Each returns whether this changed, all operands must have the same size
+		bool unionWith(const BitVector& rhs);
+		bool intersectWith(const BitVector& rhs);
+		bool assignTransfer(const BitVector& in, const BitVector& gen, const BitVector& kill);  // gen | (in & ~kill)
+	};
+}
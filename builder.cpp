@@ -0,0 +1,29 @@
+#include "builder.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace graph::core
+{
+	Edge& GraphBuilder::Local::newEdge(Vertex& from, Vertex& to, int weight, unsigned layer)
+	{
+		if (layer >= edgeLayers) throw std::invalid_argument("graph::core::GraphBuilder::Local::newEdge: no layer " + std::to_string(layer));
+		return m_graph.adopt(m_graph.allocated_edges.emplace_back(from, to, weight, layer));
+	}
+
+	GraphBuilder::GraphBuilder(unsigned locals)
+		: m_locals(locals)
+	{
+	}
+
+	Graph GraphBuilder::finish(unsigned threads)
+	{
+		std::vector<Span<Edge>> runs;
+		for (Local& local : m_locals)
+			local.m_graph.allocated_edges.for_each_run([&runs](Edge* first, size_t count) { runs.emplace_back(first, count); });
+		Graph::link(runs.data(), runs.size(), threads);
+		Graph result;
+		for (Local& local : m_locals) result.absorb(std::move(local.m_graph));
+		return result;
+	}
+}
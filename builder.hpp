@@ -0,0 +1,37 @@
+#pragma once
+#include "graph.hpp"
+
+#include <thread>
+#include <vector>
+namespace graph::core
+{
+	// Builds one Graph from several threads. Each thread creates its vertices and edges through
+	// its own Local, which allocates from private arenas without any locking; edges may connect
+	// vertices of different Locals. finish() splices all arenas into a plain Graph and links the
+	// edges into the vertex lists in parallel.
+	class GraphBuilder {
+	public:
+		class Local {
+			Graph m_graph;
+			friend class GraphBuilder;
+
+		public:
+			Vertex& newVertex() { return m_graph.newVertex(); }
+			// Not in the vertex lists before finish(), which leaves out edges removed before it.
+			// Throws std::invalid_argument for a layer past edgeLayers.
+			Edge& newEdge(Vertex& from, Vertex& to, int weight, unsigned layer = 0);
+		};
+
+	private:
+		std::vector<Local> m_locals;
+
+	public:
+		explicit GraphBuilder(unsigned locals);
+		Local& local(unsigned index) { return m_locals[index]; }
+
+		// Vertices are in Local order and then creation order, every in and out list holds its
+		// edges in the same order. Edges removed before finish(), and those of vertices removed
+		// before it, are left out. The builder is empty afterwards.
+		Graph finish(unsigned threads = std::thread::hardware_concurrency());
+	};
+}
@@ -0,0 +1,67 @@
+#include "compact.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace graph::core
+{
+	uint32_t CompactGraph::newVertex()
+	{
+		return addVertices(1);
+	}
+
+	uint32_t CompactGraph::addVertices(uint32_t count)
+	{
+		const uint32_t first = vertexCount();
+		if (count > none - first) throw std::length_error("graph::core::CompactGraph::addVertices: vertex ids exhausted");
+		m_vertices.resize(m_vertices.size() + count);
+		return first;
+	}
+
+	uint32_t CompactGraph::newEdge(uint32_t from, uint32_t to, int32_t weight)
+	{
+		if (from >= vertexCount() || to >= vertexCount())
+			throw std::out_of_range("graph::core::CompactGraph::newEdge: no vertex " + std::to_string(from >= vertexCount() ? from : to));
+		const uint32_t edge = edgeIdCount();
+		if (edge == none) throw std::length_error("graph::core::CompactGraph::newEdge: edge ids exhausted");
+		VertexRecord& source = m_vertices[from];
+		VertexRecord& target = m_vertices[to];
+		m_edges.push_back({ from, to, weight, none, source.lastOut, none, target.lastIn });
+		if (source.lastOut != none) m_edges[source.lastOut].nextOut = edge;
+		else source.firstOut = edge;
+		source.lastOut = edge;
+		if (target.lastIn != none) m_edges[target.lastIn].nextIn = edge;
+		else target.firstIn = edge;
+		target.lastIn = edge;
+		return edge;
+	}
+
+	void CompactGraph::removeEdge(uint32_t edge)
+	{
+		if (edge >= edgeIdCount()) throw std::out_of_range("graph::core::CompactGraph::removeEdge: no edge " + std::to_string(edge));
+		EdgeRecord& record = m_edges[edge];
+		if (record.from == none) return;
+		VertexRecord& source = m_vertices[record.from];
+		VertexRecord& target = m_vertices[record.to];
+		(record.prevOut != none ? m_edges[record.prevOut].nextOut : source.firstOut) = record.nextOut;
+		(record.nextOut != none ? m_edges[record.nextOut].prevOut : source.lastOut) = record.prevOut;
+		(record.prevIn != none ? m_edges[record.prevIn].nextIn : target.firstIn) = record.nextIn;
+		(record.nextIn != none ? m_edges[record.nextIn].prevIn : target.lastIn) = record.prevIn;
+		record = { none, none, 0, none, none, none, none };
+		m_removed++;
+	}
+
+	void CompactGraph::removeEdges(uint32_t vertex)
+	{
+		if (vertex >= vertexCount()) throw std::out_of_range("graph::core::CompactGraph::removeEdges: no vertex " + std::to_string(vertex));
+		// removeEdge() unlinks the edge, so always take the first one
+		while (m_vertices[vertex].firstIn != none) removeEdge(m_vertices[vertex].firstIn);
+		while (m_vertices[vertex].firstOut != none) removeEdge(m_vertices[vertex].firstOut);
+	}
+
+	void CompactGraph::reserve(size_t vertices, size_t edges)
+	{
+		m_vertices.reserve(m_vertices.size() + vertices);
+		m_edges.reserve(m_edges.size() + edges);
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+namespace graph::core
+{
+	// Mutable graph that stores vertices and edges as records in arrays and links them by
+	// 32-bit index instead of by pointer, for designs too large to load as a Graph. An edge
+	// takes 28 bytes against the 80 of an Edge. Vertices and edges are plain ids, dense in
+	// creation order; ids of removed edges are not reused. In and out lists keep insertion
+	// order like those of a Graph and removing an edge takes constant time. Records live in
+	// fixed size blocks, so growing never copies them or holds the old and new arrays at once.
+	class CompactGraph {
+	public:
+		static constexpr uint32_t none = UINT32_MAX;
+
+	private:
+		struct VertexRecord {
+			uint32_t firstOut = none;
+			uint32_t lastOut = none;
+			uint32_t firstIn = none;
+			uint32_t lastIn = none;
+		};
+		struct EdgeRecord {
+			uint32_t from;
+			uint32_t to;
+			int32_t weight;
+			uint32_t nextOut;
+			uint32_t prevOut;
+			uint32_t nextIn;
+			uint32_t prevIn;
+		};
+
+		// Records indexed by id, blockSize at a time
+		template <typename T>
+		class Blocks {
+			static constexpr unsigned shift = 12;
+			static constexpr size_t blockSize = size_t{ 1 } << shift;
+			std::vector<std::unique_ptr<T[]>> m_blocks;
+			size_t m_size = 0;
+
+		public:
+			size_t size() const { return m_size; }
+			T& operator[](size_t i) { return m_blocks[i >> shift][i & (blockSize - 1)]; }
+			const T& operator[](size_t i) const { return m_blocks[i >> shift][i & (blockSize - 1)]; }
+			void reserve(size_t size) {
+				while (m_blocks.size() * blockSize < size) m_blocks.push_back(std::make_unique<T[]>(blockSize));
+			}
+			void push_back(const T& value) {
+				reserve(m_size + 1);
+				(*this)[m_size++] = value;
+			}
+			void resize(size_t size) {
+				reserve(size);
+				for (; m_size < size; m_size++) (*this)[m_size] = T{};
+			}
+		};
+		Blocks<VertexRecord> m_vertices;
+		Blocks<EdgeRecord> m_edges;
+		uint32_t m_removed = 0;
+
+	public:
+		// Throw std::length_error once ids would reach none
+		uint32_t newVertex();
+		uint32_t addVertices(uint32_t count);  // Id of the first of count consecutive vertices
+		uint32_t newEdge(uint32_t from, uint32_t to, int32_t weight);  // Throws std::out_of_range for an unknown vertex
+
+		// Throw std::out_of_range for an unknown edge or vertex
+		void removeEdge(uint32_t edge);
+		void removeEdges(uint32_t vertex);  // All in and out edges of the vertex
+		void reserve(size_t vertices, size_t edges);  // Allocates the blocks up front
+
+		uint32_t vertexCount() const { return static_cast<uint32_t>(m_vertices.size()); }
+		uint32_t edgeCount() const { return edgeIdCount() - m_removed; }  // Edges not removed
+		uint32_t edgeIdCount() const { return static_cast<uint32_t>(m_edges.size()); }
+		bool removed(uint32_t edge) const { return m_edges[edge].from == none; }
+		uint32_t from(uint32_t edge) const { return m_edges[edge].from; }
+		uint32_t to(uint32_t edge) const { return m_edges[edge].to; }
+		int32_t weight(uint32_t edge) const { return m_edges[edge].weight; }
+
+		// Calls f(edge) for each out or in edge of the vertex, in list order. f must not
+		// remove edges of the vertex.
+		template <typename F>
+		void forEachOutEdge(uint32_t vertex, F&& f) const {
+			for (uint32_t edge = m_vertices[vertex].firstOut; edge != none; edge = m_edges[edge].nextOut) f(edge);
+		}
+		template <typename F>
+		void forEachInEdge(uint32_t vertex, F&& f) const {
+			for (uint32_t edge = m_vertices[vertex].firstIn; edge != none; edge = m_edges[edge].nextIn) f(edge);
+		}
+	};
+}
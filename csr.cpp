@@ -0,0 +1,85 @@
+#include "csr.hpp"
+
+#include <stdexcept>
+
+namespace graph::alg
+{
+	CsrGraph::CsrGraph(const Graph& graph, EdgeFunc func, LayerSet layers)
+	{
+		m_ids.assign(graph.vertexIdCount(), noId);
+		for (const Vertex& vertex : graph.vertices()) {
+			m_ids[vertex.id()] = static_cast<uint32_t>(m_vertices.size());
+			m_vertices.push_back(vertex);
+		}
+
+		m_outOffsets.reserve(m_vertices.size() + 1);
+		m_outOffsets.push_back(0);
+		std::vector<uint32_t> inDegree(m_vertices.size() + 1, 0);
+		for (const Vertex& vertex : graph.vertices()) {
+			vertex.forEachOutEdgeIn(layers, [&](const Edge& edge) {
+				if (func(edge)) {
+					const uint32_t to = m_ids[edge.to().id()];
+					m_outTargets.push_back(to);
+					m_outWeights.push_back(edge.weight());
+					inDegree[to + 1]++;
+				}
+			});
+			m_outOffsets.push_back(static_cast<uint32_t>(m_outTargets.size()));
+		}
+
+		reverse(static_cast<uint32_t>(m_vertices.size()), inDegree);
+	}
+
+	uint32_t CsrGraph::id(const Vertex& vertex) const
+	{
+		if (vertex.id() >= m_ids.size() || m_ids[vertex.id()] == noId || m_vertices[m_ids[vertex.id()]].ptr() != &vertex)
+			throw std::out_of_range("graph::alg::CsrGraph::id: vertex is not in the snapshot");
+		return m_ids[vertex.id()];
+	}
+
+	CsrGraph::CsrGraph(const CompactGraph& graph)
+	{
+		const uint32_t count = graph.vertexCount();
+		m_outOffsets.reserve(count + 1);
+		m_outOffsets.push_back(0);
+		m_outTargets.reserve(graph.edgeCount());
+		m_outWeights.reserve(graph.edgeCount());
+		std::vector<uint32_t> inDegree(count + 1, 0);
+		for (uint32_t vertex = 0; vertex < count; vertex++) {
+			graph.forEachOutEdge(vertex, [&](uint32_t edge) {
+				m_outTargets.push_back(graph.to(edge));
+				m_outWeights.push_back(graph.weight(edge));
+				inDegree[graph.to(edge) + 1]++;
+			});
+			m_outOffsets.push_back(static_cast<uint32_t>(m_outTargets.size()));
+		}
+		reverse(count, inDegree);
+	}
+
+	void CsrGraph::reverse(uint32_t vertexCount, const std::vector<uint32_t>& inDegree)
+	{
+		// Scatter the out edges into the reverse rows, sources come out sorted per row
+		m_inOffsets.resize(vertexCount + 1, 0);
+		for (size_t i = 1; i < inDegree.size(); i++) m_inOffsets[i] = m_inOffsets[i - 1] + inDegree[i];
+		m_inSources.resize(m_outTargets.size());
+		m_inWeights.resize(m_outTargets.size());
+		std::vector<uint32_t> fill(m_inOffsets.begin(), m_inOffsets.end() - 1);
+		for (uint32_t from = 0; from < vertexCount; from++) {
+			for (uint32_t e = m_outOffsets[from]; e < m_outOffsets[from + 1]; e++) {
+				const uint32_t slot = fill[m_outTargets[e]]++;
+				m_inSources[slot] = from;
+				m_inWeights[slot] = m_outWeights[e];
+			}
+		}
+
+		m_arrays = { vertexCount, static_cast<uint32_t>(m_outTargets.size()),
+			m_outOffsets.data(), m_outTargets.data(), m_outWeights.data(),
+			m_inOffsets.data(), m_inSources.data(), m_inWeights.data() };
+	}
+
+	CsrGraph::CsrGraph(const Arrays& arrays, std::shared_ptr<const void> owner)
+		: m_arrays(arrays)
+		, m_owner(std::move(owner))
+	{
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "compact.hpp"
+#include "graphalg.hpp"
+
+#include <memory>
+#include <vector>
+namespace graph::alg
+{
+	// Read only snapshot of the followed edges of a Graph in compressed sparse row form.
+	// Vertices get dense ids 0..vertexCount()-1 in graph.vertices() order, edges are numbered
+	// by their position in the out rows. A snapshot can also wrap arrays owned elsewhere,
+	// e.g. a mapped file, in which case there are no Vertex objects behind the ids.
+	class CsrGraph {
+	public:
+		static constexpr uint32_t noId = UINT32_MAX;
+
+		template <typename T>
+		class Range {
+			const T* m_begin;
+			const T* m_end;
+
+		public:
+			Range(const T* begin, const T* end)
+				: m_begin(begin)
+				, m_end(end) {}
+			const T* begin() const { return m_begin; }
+			const T* end() const { return m_end; }
+			size_t size() const { return m_end - m_begin; }
+			bool empty() const { return m_begin == m_end; }
+			const T& operator[](size_t i) const { return m_begin[i]; }
+		};
+
+		// Raw arrays, offsets have vertexCount + 1 entries and the others edgeCount
+		struct Arrays {
+			uint32_t vertexCount = 0;
+			uint32_t edgeCount = 0;
+			const uint32_t* outOffsets = nullptr;
+			const uint32_t* outTargets = nullptr;
+			const int32_t* outWeights = nullptr;
+			const uint32_t* inOffsets = nullptr;
+			const uint32_t* inSources = nullptr;
+			const int32_t* inWeights = nullptr;
+		};
+
+	private:
+		Arrays m_arrays;
+		std::shared_ptr<const void> m_owner;  // Keeps external arrays alive
+		VertexBindingVec m_vertices;
+		std::vector<uint32_t> m_ids;  // Dense id by Vertex::id(), noId for vertices not in the snapshot
+		std::vector<uint32_t> m_outOffsets;
+		std::vector<uint32_t> m_outTargets;
+		std::vector<int32_t> m_outWeights;
+		std::vector<uint32_t> m_inOffsets;
+		std::vector<uint32_t> m_inSources;
+		std::vector<int32_t> m_inWeights;
+
+	public:
+		// Only the edges of the given layers, by default layer 0, go into the rows
+		explicit CsrGraph(const Graph& graph, EdgeFunc func = followAlwaysTrue, LayerSet layers = 1);
+		explicit CsrGraph(const CompactGraph& graph);  // Same ids as graph, no Vertex objects behind them
+		CsrGraph(const Arrays& arrays, std::shared_ptr<const void> owner);
+		CsrGraph(const CsrGraph&) = delete;
+		CsrGraph(CsrGraph&&) = default;  // Vector buffers move along, so m_arrays stays valid
+
+		const Arrays& arrays() const { return m_arrays; }
+		uint32_t vertexCount() const { return m_arrays.vertexCount; }
+		uint32_t edgeCount() const { return m_arrays.edgeCount; }
+		bool hasVertices() const { return !m_vertices.empty() || !vertexCount(); }
+		const Vertex& vertex(uint32_t id) const { return *m_vertices[id].ptr(); }
+		uint32_t id(const Vertex& vertex) const;  // Throws std::out_of_range for a vertex not in the snapshot
+		uint32_t firstOutEdge(uint32_t id) const { return m_arrays.outOffsets[id]; }
+		Range<uint32_t> outTargets(uint32_t id) const { return outRange(m_arrays.outTargets, id); }
+		Range<int32_t> outWeights(uint32_t id) const { return outRange(m_arrays.outWeights, id); }
+		Range<uint32_t> inSources(uint32_t id) const { return inRange(m_arrays.inSources, id); }
+		Range<int32_t> inWeights(uint32_t id) const { return inRange(m_arrays.inWeights, id); }
+
+	private:
+		void reverse(uint32_t vertexCount, const std::vector<uint32_t>& inDegree);  // In rows from the out rows
+		template <typename T>
+		Range<T> outRange(const T* data, uint32_t id) const {
+			return { data + m_arrays.outOffsets[id], data + m_arrays.outOffsets[id + 1] };
+		}
+		template <typename T>
+		Range<T> inRange(const T* data, uint32_t id) const {
+			return { data + m_arrays.inOffsets[id], data + m_arrays.inOffsets[id + 1] };
+		}
+	};
+}
@@ -0,0 +1,53 @@
+#include "dataflow.hpp"
+
+#include <algorithm>
+
+namespace graph::alg
+{
+	std::vector<uint32_t> visitOrder(const CsrGraph& csr, Direction direction)
+	{
+		// Iterative DFS, roots without predecessors first so loops are entered at their head
+		std::vector<uint32_t> postorder;
+		postorder.reserve(csr.vertexCount());
+		std::vector<bool> visited(csr.vertexCount(), false);
+		std::vector<std::pair<uint32_t, uint32_t>> frames;  // Vertex and next out edge to visit
+		auto dfs = [&](uint32_t root) {
+			visited[root] = true;
+			frames.emplace_back(root, 0);
+			while (!frames.empty()) {
+				auto& [id, next] = frames.back();
+				const auto targets = csr.outTargets(id);
+				if (next < targets.size()) {
+					const uint32_t to = targets[next++];
+					if (!visited[to]) {
+						visited[to] = true;
+						frames.emplace_back(to, 0);
+					}
+					continue;
+				}
+				postorder.push_back(id);
+				frames.pop_back();
+			}
+		};
+		for (uint32_t id = 0; id < csr.vertexCount(); id++)
+			if (!visited[id] && csr.inSources(id).empty()) dfs(id);
+		for (uint32_t id = 0; id < csr.vertexCount(); id++)
+			if (!visited[id]) dfs(id);
+
+		if (direction == Direction::Forward) std::reverse(postorder.begin(), postorder.end());
+		return postorder;
+	}
+
+	DataflowResult<BitVector> solveGenKill(const CsrGraph& csr, Direction direction, Confluence confluence,
+		const std::vector<BitVector>& gen, const std::vector<BitVector>& kill, const BitVector& boundary)
+	{
+		const bool intersect = confluence == Confluence::Intersection;
+		const BitVector init(boundary.size(), intersect);
+		return solveDataflow(csr, direction, init, boundary,
+			[&](uint32_t id, const BitVector& in, BitVector& out) { return out.assignTransfer(in, gen[id], kill[id]); },
+			[intersect](BitVector& into, const BitVector& from) {
+				if (intersect) into.intersectWith(from);
+				else into.unionWith(from);
+			});
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "bitvector.hpp"
+#include "csr.hpp"
+
+#include <cstdint>
+#include <vector>
+namespace graph::alg
+{
+	enum class Direction { Forward, Backward };
+	enum class Confluence { Union, Intersection };
+
+	template <typename State>
+	struct DataflowResult {
+		std::vector<State> in;  // Indexed by CsrGraph id, "in" is the state before the transfer function
+		std::vector<State> out;  // in the analysis direction, so for backward problems it sits at the vertex exit
+	};
+
+	// Reverse postorder of the forward DFS for forward problems, postorder for backward ones
+	std::vector<uint32_t> visitOrder(const CsrGraph& csr, Direction direction);
+
+	// Iterates to a fixed point over the vertex order of the direction.
+	//     transfer(id, in, out) -> bool    recompute out from in, return whether out changed
+	//     meet(into, from)                 fold the out state of another predecessor into into
+	// Vertices without predecessors start from boundary, all other states start from init.
+	template <typename State, typename Transfer, typename Meet>
+	DataflowResult<State> solveDataflow(const CsrGraph& csr, Direction direction,
+		const State& init, const State& boundary, Transfer&& transfer, Meet&& meet)
+	{
+		const bool forward = direction == Direction::Forward;
+		auto preds = [&](uint32_t id) { return forward ? csr.inSources(id) : csr.outTargets(id); };
+		auto succs = [&](uint32_t id) { return forward ? csr.outTargets(id) : csr.inSources(id); };
+
+		DataflowResult<State> result{ std::vector<State>(csr.vertexCount(), init), std::vector<State>(csr.vertexCount(), init) };
+		const std::vector<uint32_t> order = visitOrder(csr, direction);
+		std::vector<bool> pending(csr.vertexCount(), true);
+		bool again = true;
+		while (again) {
+			again = false;
+			for (const uint32_t id : order) {
+				if (!pending[id]) continue;
+				pending[id] = false;
+				State& in = result.in[id];
+				const auto from = preds(id);
+				if (from.empty()) {
+					in = boundary;
+				}
+				else {
+					in = result.out[from[0]];
+					for (size_t i = 1; i < from.size(); i++) meet(in, result.out[from[i]]);
+				}
+				if (!transfer(id, static_cast<const State&>(in), result.out[id])) continue;
+				for (const uint32_t to : succs(id)) {
+					pending[to] = true;
+					again = true;
+				}
+			}
+		}
+		return result;
+	}
+
+	// Classic gen/kill problems (reaching definitions, liveness, available expressions)
+	DataflowResult<BitVector> solveGenKill(const CsrGraph& csr, Direction direction, Confluence confluence,
+		const std::vector<BitVector>& gen, const std::vector<BitVector>& kill, const BitVector& boundary);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "graph.hpp"
+
+#include <type_traits>
+#include <utility>
+namespace graph::core
+{
+	template <typename T>
+	struct Payload {
+		T data;
+		template <typename... Args>
+		explicit Payload(Args&&... args)
+			: data(make(std::forward<Args>(args)...)) {}
+
+	private:
+		// Constructor arguments, or the members of an aggregate
+		template <typename... Args>
+		static T make(Args&&... args) {
+			if constexpr (std::is_constructible_v<T, Args&&...>) return T(std::forward<Args>(args)...);
+			else return T{ std::forward<Args>(args)... };
+		}
+	};
+
+	template <>
+	struct Payload<void> {};
+
+	template <typename V>
+	class DataVertex : public Vertex, public Payload<V> {
+	public:
+		template <typename... Args>
+		explicit DataVertex(Args&&... args)
+			: Payload<V>(std::forward<Args>(args)...) {}
+	};
+
+	template <typename E>
+	class DataEdge : public Edge, public Payload<E> {
+	public:
+		template <typename... Args>
+		DataEdge(Vertex& from, Vertex& to, int weight, Args&&... args)
+			: Edge(from, to, weight)
+			, Payload<E>(std::forward<Args>(args)...) {}
+	};
+
+	// Graph whose vertices and edges carry a payload stored inline, void for none. graph() is
+	// the read only Graph every algorithm takes; data() gets from the Vertex or Edge handed to
+	// a callback to its payload without a lookup. The int weight stays what the algorithms use,
+	// other weight types go into the edge payload. The Graph base is private, so nothing can
+	// add vertices or edges without a payload through it: clone() and extractSubgraph() of
+	// graph() copy the structure only, and a DataGraph only absorbs DataGraphs of the same type.
+	template <typename V = void, typename E = void>
+	class DataGraph : private Graph {
+	public:
+		using VertexType = DataVertex<V>;
+		using EdgeType = DataEdge<E>;
+
+	private:
+		arena<VertexType> m_vertices;
+		arena<EdgeType> m_edges;
+
+	public:
+		DataGraph() = default;
+		~DataGraph() {
+			active_vertices.clear();
+			m_vertices.clear();
+			m_edges.clear();
+		}
+		DataGraph(DataGraph&&) noexcept = default;
+		DataGraph& operator=(DataGraph&& other) noexcept {
+			DataGraph old(std::move(other));
+			swap(old);
+			return *this;
+		}
+		void swap(DataGraph& other) noexcept {
+			Graph::swap(other);
+			m_vertices.swap(other.m_vertices);
+			m_edges.swap(other.m_edges);
+		}
+		void absorb(DataGraph&& other) noexcept {
+			shiftIds(other.m_vertices, other.m_edges);
+			Graph::absorb(std::move(other));
+			m_vertices.splice(std::move(other.m_vertices));
+			m_edges.splice(std::move(other.m_edges));
+		}
+
+		// Arguments construct the payload
+		template <typename... Args>
+		VertexType& newVertex(Args&&... args) {
+			VertexType& vertex = m_vertices.emplace_back(std::forward<Args>(args)...);
+			adopt(vertex);
+			return vertex;
+		}
+		template <typename... Args>
+		EdgeType& newEdge(Vertex& from, Vertex& to, int weight, Args&&... args) {
+			EdgeType& edge = m_edges.emplace_back(from, to, weight, std::forward<Args>(args)...);
+			adopt(edge);
+			linkOut(edge);
+			linkIn(edge);
+			return edge;
+		}
+		void reserve(size_t vertices, size_t edges) {
+			if (vertices) m_vertices.reserve(vertices);
+			if (edges) m_edges.reserve(edges);
+		}
+
+		const Graph& graph() const { return *this; }
+		using Graph::vertices;
+		using Graph::vertexIdCount;
+		using Graph::edgeIdCount;
+
+		// Only for vertices and edges of a DataGraph<V, E>
+		template <typename T = V>
+		static std::enable_if_t<!std::is_void_v<T>, const T&> data(const Vertex& vertex) { return static_cast<const VertexType&>(vertex).data; }
+		template <typename T = V>
+		static std::enable_if_t<!std::is_void_v<T>, T&> data(Vertex& vertex) { return static_cast<VertexType&>(vertex).data; }
+		template <typename T = E>
+		static std::enable_if_t<!std::is_void_v<T>, const T&> data(const Edge& edge) { return static_cast<const EdgeType&>(edge).data; }
+		template <typename T = E>
+		static std::enable_if_t<!std::is_void_v<T>, T&> data(Edge& edge) { return static_cast<EdgeType&>(edge).data; }
+	};
+
+	template <typename V, typename E>
+	void swap(DataGraph<V, E>& a, DataGraph<V, E>& b) noexcept { a.swap(b); }
+}
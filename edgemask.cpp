@@ -0,0 +1,43 @@
+#include "edgemask.hpp"
+
+#include <stdexcept>
+
+namespace graph::alg
+{
+	EdgeMask::EdgeMask(const Graph& graph, const EdgeFunc& func)
+		: m_bits(graph.edgeIdCount())
+	{
+		for (const Vertex& vertex : graph.vertices())
+			vertex.forEachOutEdge([this, &func](const Edge& edge) {
+				if (func(edge)) m_bits.set(edge.id());
+			});
+	}
+
+	EdgeMask::EdgeMask(const Mask& flags)
+		: m_bits(flags.size())
+	{
+		for (size_t i = 0; i < flags.size(); i++)
+			if (flags[i]) m_bits.set(i);
+	}
+
+	size_t EdgeMask::countOut(const Vertex& vertex) const
+	{
+		size_t total = 0;
+		vertex.forEachOutEdge([this, &total](const Edge& edge) { total += test(edge); });
+		return total;
+	}
+
+	EdgeMask& EdgeMask::operator&=(const EdgeMask& rhs)
+	{
+		if (size() != rhs.size()) throw std::invalid_argument("graph::alg::EdgeMask::operator&=: masks of different sizes");
+		m_bits.intersectWith(rhs.m_bits);
+		return *this;
+	}
+
+	EdgeMask& EdgeMask::operator|=(const EdgeMask& rhs)
+	{
+		if (size() != rhs.size()) throw std::invalid_argument("graph::alg::EdgeMask::operator|=: masks of different sizes");
+		m_bits.unionWith(rhs.m_bits);
+		return *this;
+	}
+}
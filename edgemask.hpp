@@ -0,0 +1,38 @@
+#pragma once
+#include "attributes.hpp"
+#include "bitvector.hpp"
+#include "graphalg.hpp"
+
+namespace graph::alg
+{
+	// An edge predicate evaluated once, packed one bit per Edge::id(). The algorithms of
+	// graphalg.hpp take it in place of an EdgeFunc, so repeated visits cost a bit test instead of
+	// a call; func() adapts it for everything else. Edges created after the mask are not followed.
+	class EdgeMask {
+		BitVector m_bits;
+
+	public:
+		explicit EdgeMask(const Graph& graph, const EdgeFunc& func = followAlwaysTrue);
+		explicit EdgeMask(const Mask& flags);  // Edge column flags, e.g. from maskColumn()
+
+		bool test(const Edge& edge) const { return edge.id() < m_bits.size() && m_bits.test(edge.id()); }
+		size_t size() const { return m_bits.size(); }
+		size_t count() const { return m_bits.count(); }  // Followed edges
+		size_t countOut(const Vertex& vertex) const;  // Followed out edges of the vertex
+
+		// Both made from the same graph without edges added in between, std::invalid_argument
+		// if the sizes differ
+		EdgeMask& operator&=(const EdgeMask& rhs);
+		EdgeMask& operator|=(const EdgeMask& rhs);
+
+		// Valid as long as the mask is
+		EdgeFunc func() const {
+			return [this](const Edge& edge) { return test(edge); };
+		}
+	};
+
+	// followEdge() for a mask, a bit test with no call through std::function
+	inline auto followEdge(const EdgeMask& mask) {
+		return [&mask](const Edge& edge) { return edge.weight() && mask.test(edge); };
+	}
+}
@@ -0,0 +1,187 @@
+#include "executor.hpp"
+#include "csr.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+using graph::alg::CsrGraph;
+
+namespace graph::exec
+{
+	struct Executor::Job {
+		const CsrGraph& csr;
+		const VertexTask& task;
+		std::vector<std::atomic<uint32_t>> pending;  // Unfinished predecessors per vertex
+		std::atomic<uint32_t> remaining;
+		std::atomic<uint32_t> queued{ 0 };  // In the deques, may lag a pop by a moment
+		std::atomic<uint32_t> sleepers{ 0 };
+		std::atomic<bool> failed{ false };
+		std::exception_ptr error;
+		std::mutex errorMutex;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+
+		Job(const CsrGraph& csr, const VertexTask& task)
+			: csr(csr)
+			, task(task)
+			, pending(csr.vertexCount())
+			, remaining(csr.vertexCount()) {}
+		bool done() const { return !remaining.load(std::memory_order_acquire) || failed.load(std::memory_order_relaxed); }
+		void wakeAll() {
+			{ std::lock_guard<std::mutex> lock(sleepMutex); }  // A worker between its check and its wait is waiting now
+			wake.notify_all();
+		}
+	};
+
+	Executor::Executor(unsigned threads)
+	{
+		threads = std::max(1u, threads);
+		for (unsigned i = 0; i < threads; i++) m_workers.push_back(std::make_unique<Worker>());
+		for (unsigned i = 1; i < threads; i++) m_threads.emplace_back(&Executor::threadMain, this, i);
+	}
+
+	Executor::~Executor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (auto& thread : m_threads) thread.join();
+	}
+
+	void Executor::threadMain(uint32_t self)
+	{
+		uint64_t seen = 0;
+		while (true) {
+			Job* job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+				if (m_stop) return;
+				seen = m_generation;
+				job = m_job;
+			}
+			work(*job, self);
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!--m_busy) m_idle.notify_all();
+			}
+		}
+	}
+
+	void Executor::push(uint32_t self, uint32_t id)
+	{
+		Worker& worker = *m_workers[self];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.ready.push_back(id);
+	}
+
+	bool Executor::pop(uint32_t self, uint32_t& id)
+	{
+		{
+			Worker& worker = *m_workers[self];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			if (!worker.ready.empty()) {
+				id = worker.ready.back();
+				worker.ready.pop_back();
+				return true;
+			}
+		}
+		for (size_t i = 1; i < m_workers.size(); i++) {
+			Worker& victim = *m_workers[(self + i) % m_workers.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.ready.empty()) {
+				id = victim.ready.front();
+				victim.ready.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Executor::execute(Job& job, uint32_t self, uint32_t id)
+	{
+		try {
+			job.task(job.csr.vertex(id));
+		}
+		catch (...) {
+			{
+				std::lock_guard<std::mutex> lock(job.errorMutex);
+				if (!job.error) job.error = std::current_exception();
+				job.failed.store(true, std::memory_order_relaxed);
+			}
+			job.wakeAll();
+			return;  // Dependents of a failed task never become ready
+		}
+		uint32_t released = 0;
+		for (const uint32_t to : job.csr.outTargets(id))
+			if (job.pending[to].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				job.queued.fetch_add(1);
+				push(self, to);
+				released++;
+			}
+		if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) job.wakeAll();
+		else if (released > 1 && job.sleepers.load()) job.wakeAll();  // This thread takes one, others the rest
+	}
+
+	void Executor::work(Job& job, uint32_t self)
+	{
+		// queued is raised before sleepers is read and sleepers before queued is read, so either
+		// the pusher sees a sleeper and wakes it, or the sleeper sees the work and stays up
+		uint32_t id;
+		while (!job.done()) {
+			if (pop(self, id)) {
+				job.queued.fetch_sub(1);
+				execute(job, self, id);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(job.sleepMutex);
+			job.sleepers.fetch_add(1);
+			job.wake.wait(lock, [&] { return job.done() || job.queued.load() > 0; });
+			job.sleepers.fetch_sub(1);
+		}
+	}
+
+	void Executor::run(const Graph& graph, VertexTask task, EdgeFunc func)
+	{
+		std::lock_guard<std::mutex> runLock(m_runMutex);
+		const CsrGraph csr(graph, [&func](const Edge& edge) { return edge.weight() && func(edge); });
+		Job job(csr, task);
+
+		// Check for cycles up front, a cycle would leave the workers waiting forever
+		std::vector<uint32_t> order;
+		for (uint32_t id = 0; id < csr.vertexCount(); id++) {
+			job.pending[id].store(static_cast<uint32_t>(csr.inSources(id).size()), std::memory_order_relaxed);
+			if (csr.inSources(id).empty()) order.push_back(id);
+		}
+		const size_t sources = order.size();
+		{
+			std::vector<uint32_t> degree(csr.vertexCount());
+			for (uint32_t id = 0; id < csr.vertexCount(); id++) degree[id] = static_cast<uint32_t>(csr.inSources(id).size());
+			for (size_t head = 0; head < order.size(); head++)
+				for (const uint32_t to : csr.outTargets(order[head]))
+					if (!--degree[to]) order.push_back(to);
+			if (order.size() != csr.vertexCount()) throw std::invalid_argument("graph::exec::Executor::run: graph has a cycle");
+		}
+		if (!csr.vertexCount()) return;
+
+		for (size_t i = 0; i < sources; i++) m_workers[i % m_workers.size()]->ready.push_back(order[i]);
+		job.queued.store(static_cast<uint32_t>(sources));
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_job = &job;
+			m_busy = static_cast<uint32_t>(m_threads.size());
+			m_generation++;
+		}
+		m_wake.notify_all();
+		work(job, 0);
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_idle.wait(lock, [&] { return !m_busy; });
+			m_job = nullptr;
+		}
+		for (auto& worker : m_workers) worker->ready.clear();  // Leftovers of a failed run
+		if (job.error) std::rethrow_exception(job.error);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "graphalg.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace graph::exec
+{
+	using namespace graph::core;
+
+	using VertexTask = std::function<void(const Vertex&)>;
+
+	// Runs a dependency Graph on a fixed pool of threads. A vertex becomes ready once every
+	// predecessor over a followed edge has finished; each thread works LIFO from its own deque
+	// and steals FIFO from the others when it runs dry.
+	class Executor {
+		struct Job;
+		struct Worker {
+			std::mutex mutex;
+			std::deque<uint32_t> ready;
+		};
+
+		std::vector<std::unique_ptr<Worker>> m_workers;  // Slot 0 belongs to the thread calling run()
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_idle;
+		Job* m_job = nullptr;
+		uint64_t m_generation = 0;
+		uint32_t m_busy = 0;
+		bool m_stop = false;
+		std::mutex m_runMutex;
+
+		void threadMain(uint32_t self);
+		void work(Job& job, uint32_t self);
+		bool pop(uint32_t self, uint32_t& id);
+		void push(uint32_t self, uint32_t id);
+		void execute(Job& job, uint32_t self, uint32_t id);
+
+	public:
+		explicit Executor(unsigned threads = std::thread::hardware_concurrency());
+		~Executor();
+		Executor(const Executor&) = delete;
+		Executor& operator=(const Executor&) = delete;
+		unsigned threads() const { return static_cast<unsigned>(m_workers.size()); }
+
+		// Calls task once per vertex in dependency order, zero weight edges are not followed.
+		// Throws std::invalid_argument if the followed edges form a cycle, and rethrows the
+		// first exception thrown by a task after the running tasks have drained. Once a task
+		// has thrown no further task starts, and dependents of the failed task never run.
+		// Idle threads sleep until a task becomes ready.
+		void run(const Graph& graph, VertexTask task, EdgeFunc func = graph::alg::followAlwaysTrue);
+	};
+}
@@ -0,0 +1,165 @@
+#include "generators.hpp"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+using namespace graph::core;
+
+namespace generate
+{
+	struct Arc {
+		uint32_t from;
+		uint32_t to;
+	};
+
+	constexpr uint64_t blockSize = 1 << 16;
+
+	// Fill count arcs with make(rng, index). Every block of arcs has its own engine seeded from
+	// (seed, block), so the output is the same for any number of threads.
+	template <typename F>
+	std::vector<Arc> arcs(uint64_t count, const graph::gen::GeneratorOptions& options, F&& make) {
+		std::vector<Arc> result(count);
+		const uint64_t blocks = (count + blockSize - 1) / blockSize;
+		auto work = [&](uint64_t first) {
+			for (uint64_t block = first; block < blocks; block += std::max(1u, options.threads)) {
+				std::seed_seq seq{ static_cast<uint32_t>(options.seed), static_cast<uint32_t>(options.seed >> 32),
+					static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32) };
+				std::mt19937_64 rng(seq);
+				const uint64_t end = std::min(count, (block + 1) * blockSize);
+				for (uint64_t i = block * blockSize; i < end; i++) result[i] = make(rng, i);
+			}
+		};
+		std::vector<std::thread> threads;
+		for (unsigned t = 1; t < options.threads && t < blocks; t++) threads.emplace_back(work, t);
+		work(0);
+		for (auto& thread : threads) thread.join();
+		return result;
+	}
+
+	std::vector<Vertex*> build(Graph& graph, uint32_t vertices, const std::vector<Arc>& arcs, const graph::gen::GeneratorOptions& options) {
+		std::vector<Vertex*> result;
+		result.reserve(vertices);
+		for (Vertex& vertex : graph.addVertices(vertices)) result.push_back(&vertex);
+		std::vector<EdgeSpec> specs;
+		specs.reserve(arcs.size());
+		for (const Arc& arc : arcs) specs.push_back({ *result[arc.from], *result[arc.to], options.weight });
+		graph.addEdges(specs, options.threads);
+		return result;
+	}
+
+	uint32_t uniform(std::mt19937_64& rng, uint32_t bound) {
+		return std::uniform_int_distribution<uint32_t>(0, bound - 1)(rng);
+	}
+}
+
+namespace graph::gen
+{
+	std::vector<Vertex*> erdosRenyi(Graph& graph, uint32_t vertices, uint64_t edges, const GeneratorOptions& options)
+	{
+		if (vertices < 2) edges = 0;
+		const auto arcs = generate::arcs(edges, options, [vertices](std::mt19937_64& rng, uint64_t) {
+			const uint32_t from = generate::uniform(rng, vertices);
+			uint32_t to;
+			do to = generate::uniform(rng, vertices);
+			while (to == from);
+			return generate::Arc{ from, to };
+		});
+		return generate::build(graph, vertices, arcs, options);
+	}
+
+	std::vector<Vertex*> rmat(Graph& graph, uint32_t scale, uint64_t edges, double a, double b, double c, const GeneratorOptions& options)
+	{
+		if (scale >= 32) throw std::invalid_argument("graph::gen::rmat: scale must be below 32");
+		const auto arcs = generate::arcs(edges, options, [=](std::mt19937_64& rng, uint64_t) {
+			std::uniform_real_distribution<double> quadrant(0, 1);
+			generate::Arc arc{ 0, 0 };
+			for (uint32_t bit = 0; bit < scale; bit++) {
+				const double r = quadrant(rng);
+				arc.from = arc.from << 1 | (r >= a + b);
+				arc.to = arc.to << 1 | ((r >= a && r < a + b) || r >= a + b + c);
+			}
+			return arc;
+		});
+		return generate::build(graph, uint32_t{ 1 } << scale, arcs, options);
+	}
+
+	std::vector<Vertex*> layeredDag(Graph& graph, uint32_t layers, uint32_t width, uint32_t fanin, double reconvergence, const GeneratorOptions& options)
+	{
+		const uint64_t gates = layers > 1 ? uint64_t{ layers - 1 } * width : 0;
+		const auto arcs = generate::arcs(gates * fanin, options, [=](std::mt19937_64& rng, uint64_t i) {
+			const uint32_t gate = static_cast<uint32_t>(i / fanin) + width;
+			const uint32_t column = gate % width;
+			const uint32_t previous = gate - column - width;
+			uint32_t from;
+			if (std::bernoulli_distribution(reconvergence)(rng)) {
+				const uint32_t low = column > fanin ? column - fanin : 0;
+				const uint32_t high = std::min(width - 1, column + fanin);
+				from = low + generate::uniform(rng, high - low + 1);
+			}
+			else {
+				from = generate::uniform(rng, width);
+			}
+			return generate::Arc{ previous + from, gate };
+		});
+		return generate::build(graph, layers * width, arcs, options);
+	}
+
+	std::vector<Vertex*> randomDag(Graph& graph, uint32_t vertices, uint32_t degree, const GeneratorOptions& options)
+	{
+		const uint64_t sources = vertices > 1 ? vertices - 1 : 0;
+		const auto arcs = generate::arcs(sources * degree, options, [=](std::mt19937_64& rng, uint64_t i) {
+			const uint32_t from = static_cast<uint32_t>(i / degree);
+			return generate::Arc{ from, from + 1 + generate::uniform(rng, vertices - from - 1) };
+		});
+		return generate::build(graph, vertices, arcs, options);
+	}
+
+	std::vector<Vertex*> powerLaw(Graph& graph, uint32_t vertices, uint32_t degree, const GeneratorOptions& options)
+	{
+		// Every vertex is in targets once, plus once per in edge
+		std::mt19937_64 rng(options.seed);
+		std::vector<generate::Arc> arcs;
+		std::vector<uint32_t> targets;
+		if (vertices) targets.push_back(0);
+		for (uint32_t i = 1; i < vertices; i++) {
+			for (uint32_t d = 0; d < degree; d++) {
+				const uint32_t to = targets[std::uniform_int_distribution<size_t>(0, targets.size() - 1)(rng)];
+				arcs.push_back({ i, to });
+				targets.push_back(to);
+			}
+			targets.push_back(i);
+		}
+		return generate::build(graph, vertices, arcs, options);
+	}
+
+	std::vector<Vertex*> chains(Graph& graph, uint32_t vertices, uint32_t length, const GeneratorOptions& options)
+	{
+		length = std::max(1u, length);
+		std::vector<generate::Arc> arcs;
+		for (uint32_t i = 0; i + 1 < vertices; i++)
+			if ((i + 1) % length) arcs.push_back({ i, i + 1 });
+		return generate::build(graph, vertices, arcs, options);
+	}
+
+	std::vector<Vertex*> plantedSccs(Graph& graph, uint32_t vertices, uint32_t sccSize, uint64_t extraEdges, const GeneratorOptions& options)
+	{
+		sccSize = std::max(1u, sccSize);
+		std::vector<generate::Arc> rings;
+		for (uint32_t base = 0; base < vertices; base += sccSize) {
+			const uint32_t end = std::min(vertices, base + sccSize);
+			if (end - base > 1)
+				for (uint32_t i = base; i < end; i++) rings.push_back({ i, i + 1 < end ? i + 1 : base });
+		}
+		if (!vertices) extraEdges = 0;
+		auto arcs = generate::arcs(extraEdges, options, [=](std::mt19937_64& rng, uint64_t) {
+			// Edges either stay in the group or point forward, which never merges two groups
+			const uint32_t from = generate::uniform(rng, vertices);
+			const uint32_t to = from - from % sccSize + generate::uniform(rng, vertices - from + from % sccSize);
+			return generate::Arc{ from, to };
+		});
+		arcs.insert(arcs.begin(), rings.begin(), rings.end());
+		return generate::build(graph, vertices, arcs, options);
+	}
+}
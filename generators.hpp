@@ -0,0 +1,46 @@
+#pragma once
+#include "graph.hpp"
+
+#include <cstdint>
+#include <vector>
+namespace graph::gen
+{
+	using namespace graph::core;
+
+	struct GeneratorOptions {
+		uint64_t seed = 1;
+		unsigned threads = 1;  // Used to draw and link edges; blocks are seeded independently, so the result does not depend on this
+		int weight = 1;
+	};
+
+	// Vertices are appended to graph, the returned vector holds them in generator index order
+
+	// G(n, m): edges endpoints drawn uniformly, self loops are redrawn, parallel edges are kept
+	std::vector<Vertex*> erdosRenyi(Graph& graph, uint32_t vertices, uint64_t edges, const GeneratorOptions& options = {});
+
+	// Recursive matrix (Kronecker) graph on 2^scale vertices with skewed degree distribution.
+	// Throws std::invalid_argument for scale >= 32.
+	std::vector<Vertex*> rmat(Graph& graph, uint32_t scale, uint64_t edges,
+		double a = 0.57, double b = 0.19, double c = 0.19, const GeneratorOptions& options = {});
+
+	// layers x width gates, each reads fanin gates of the previous layer. With probability
+	// reconvergence a fanin comes from the columns next to the gate, so neighbouring gates share
+	// inputs and paths reconverge; otherwise it is drawn from the whole previous layer.
+	std::vector<Vertex*> layeredDag(Graph& graph, uint32_t layers, uint32_t width, uint32_t fanin,
+		double reconvergence, const GeneratorOptions& options = {});
+
+	// degree out edges per vertex, each to a uniformly drawn later vertex, so the graph is acyclic
+	std::vector<Vertex*> randomDag(Graph& graph, uint32_t vertices, uint32_t degree, const GeneratorOptions& options = {});
+
+	// Preferential attachment: each vertex links to degree earlier vertices picked in proportion
+	// to their in degree + 1, so in degrees follow a power law. Drawn by one thread.
+	std::vector<Vertex*> powerLaw(Graph& graph, uint32_t vertices, uint32_t degree, const GeneratorOptions& options = {});
+
+	// Paths of length vertices each, one after the other
+	std::vector<Vertex*> chains(Graph& graph, uint32_t vertices, uint32_t length, const GeneratorOptions& options = {});
+
+	// Consecutive groups of sccSize vertices closed into rings, plus extraEdges random edges that
+	// stay inside a group or go to a later group, so the groups are exactly the strongly connected components
+	std::vector<Vertex*> plantedSccs(Graph& graph, uint32_t vertices, uint32_t sccSize, uint64_t extraEdges,
+		const GeneratorOptions& options = {});
+}
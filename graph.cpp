@@ -1,41 +1,110 @@
 #include "graph.hpp"
+#include "graphalg.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 namespace graph::core
 {
-	Edge::Edge(Graph& graph, Vertex& from, Vertex& to, int weight)
-		: m_graph(graph)
-		, m_from(from)
+	Edge::Edge(Vertex& from, Vertex& to, int weight, unsigned layer)
+		: m_from(from)
 		, m_to(to)
 		, m_weight(weight)
+		, m_layer(static_cast<uint8_t>(layer))
 	{
-		m_from.m_out.push_back(*this);
-		m_to.m_in.push_back(*this);
 	}
 
 	const Vertex& Edge::from() const { return m_from; }
 
 	const Vertex& Edge::to() const { return m_to; }
 
-	Vertex::Vertex(Graph& graph)
-		: m_graph(graph) {
-		m_graph.active_vertices.insert(m_graph.active_vertices.end(), *this);
+	void Vertex::removeEdges() {
+#ifdef GRAPH_INLINE_OUT_EDGES
+		// All out edges go, so drop the index at once instead of shifting it per edge
+		for (Edge& edge : m_out) edge.m_outLinked = false;
+		dropOutIndex();
+#endif
+		// remove() unlinks the edge, so always take the first one
+		for (unsigned layer = 0; layer < edgeLayers && (!layer || m_layers); layer++) {
+			while (!in(layer).empty()) in(layer).front().remove();
+			while (!out(layer).empty()) out(layer).front().remove();
+		}
 	}
 
-	void Vertex::removeEdges() {
-		for (Edge& inEdge : m_in) inEdge.remove();
-		for (Edge& outEdge : m_out) outEdge.remove();
+	const intrusive_list<Edge, Reverse>& Vertex::inEdges(unsigned layer) const {
+		static const intrusive_list<Edge, Reverse> none;
+		if (layer >= edgeLayers) throw std::invalid_argument("graph::core::Vertex::inEdges: no layer " + std::to_string(layer));
+		return !layer ? m_in : m_layers ? m_layers->in[layer - 1] : none;
+	}
+
+	const intrusive_list<Edge, Forward>& Vertex::outEdges(unsigned layer) const {
+		static const intrusive_list<Edge, Forward> none;
+		if (layer >= edgeLayers) throw std::invalid_argument("graph::core::Vertex::outEdges: no layer " + std::to_string(layer));
+		return !layer ? m_out : m_layers ? m_layers->out[layer - 1] : none;
 	}
 
+	void Vertex::appendOut(Edge& edge) {
+		out(edge.m_layer).push_back(edge);
+		if (edge.m_layer) return;
+#ifdef GRAPH_INLINE_OUT_EDGES
+		if (m_outDegree < inlineOutEdges) {
+			m_inline[m_outDegree] = &edge;
+		}
+		else if (m_outDegree == inlineOutEdges || m_outDegree == m_chunk.capacity) {
+			// Spill the inline pointers, or grow the chunk
+			const uint32_t capacity = 2 * m_outDegree;
+			const Edge** edges = new const Edge*[capacity];
+			std::copy_n(outIndex(), m_outDegree, edges);
+			if (m_outDegree > inlineOutEdges) delete[] m_chunk.edges;
+			m_chunk = { edges, capacity };
+			edges[m_outDegree] = &edge;
+		}
+		else {
+			m_chunk.edges[m_outDegree] = &edge;
+		}
+#endif
+		m_outDegree++;
+		edge.m_outLinked = true;
+	}
+
+	void Vertex::eraseOut(Edge& edge) {
+		out(edge.m_layer).erase(edge);
+		if (!edge.m_outLinked) return;
+		edge.m_outLinked = false;
+#ifdef GRAPH_INLINE_OUT_EDGES
+		const Edge** edges = m_outDegree <= inlineOutEdges ? m_inline : m_chunk.edges;
+		const Edge** at = std::find(edges, edges + m_outDegree, &edge);
+		std::copy(at + 1, edges + m_outDegree, at);
+		if (m_outDegree == inlineOutEdges + 1) {
+			// Fits inline again
+			std::copy_n(edges, inlineOutEdges, m_inline);
+			delete[] edges;
+		}
+#endif
+		m_outDegree--;
+	}
+
+#ifdef GRAPH_INLINE_OUT_EDGES
+	void Vertex::dropOutIndex() {
+		if (m_outDegree > inlineOutEdges) delete[] m_chunk.edges;
+		m_outDegree = 0;
+	}
+#endif
+
 	void Vertex::remove() {
 		removeEdges();
-		m_graph.active_vertices.erase(*this);
+		unlink();
 	}
 
 	int Edge::weight() const { return m_weight; }
 
 	void Edge::remove() {
-		m_from.m_out.erase(*this);
-		m_to.m_in.erase(*this);
+		m_removed = true;
+		m_from.eraseOut(*this);
+		m_to.in(m_layer).erase(*this);
 	}
 
 	Graph::~Graph() {
@@ -44,12 +113,205 @@ namespace graph::core
 		allocated_edges.clear();
 	}
 
+	Graph& Graph::operator=(Graph&& other) noexcept {
+		Graph old(std::move(other));
+		swap(old);
+		return *this;
+	}
+
+	void Graph::swap(Graph& other) noexcept {
+		allocated_vertices.swap(other.allocated_vertices);
+		allocated_edges.swap(other.allocated_edges);
+		active_vertices.swap(other.active_vertices);
+		std::swap(m_vertexIds, other.m_vertexIds);
+		std::swap(m_edgeIds, other.m_edgeIds);
+	}
+
+	void Graph::absorb(Graph&& other) noexcept {
+		if (&other == this) return;
+		// Every element other allocated, also removed ones and edges not linked yet
+		shiftIds(other.allocated_vertices, other.allocated_edges);
+		m_vertexIds += std::exchange(other.m_vertexIds, 0);
+		m_edgeIds += std::exchange(other.m_edgeIds, 0);
+		allocated_vertices.splice(std::move(other.allocated_vertices));
+		allocated_edges.splice(std::move(other.allocated_edges));
+		active_vertices.splice(active_vertices.end(), other.active_vertices, other.active_vertices.begin(), other.active_vertices.end());
+	}
+
+	Graph Graph::clone() const {
+		return std::get<0>(extractSubgraph(*this, nullptr, nullptr));
+	}
+
+	std::tuple<Graph, std::vector<Vertex*>> extractSubgraph(const Graph& graph, const VertexFunc& keep, const EdgeFunc& func) {
+		// Position + 1 of the copy by vertex id, 0 for vertices left out
+		std::vector<uint32_t> vertexCopy(graph.vertexIdCount());
+		std::vector<const Vertex*> order;
+		for (const Vertex& vertex : graph.vertices())
+			if (!keep || keep(vertex)) {
+				order.push_back(&vertex);
+				vertexCopy[vertex.id()] = static_cast<uint32_t>(order.size());
+			}
+		Graph result = Graph::copy(graph, order, vertexCopy, func);
+		std::vector<Vertex*> mapping;
+		auto copies = result.active_vertices.begin();
+		for (const Vertex& vertex : graph.vertices())
+			mapping.push_back(vertexCopy[vertex.id()] ? &*copies++ : nullptr);
+		return { std::move(result), std::move(mapping) };
+	}
+
+	Graph Graph::copy(const Graph& graph, const std::vector<const Vertex*>& order, const std::vector<uint32_t>& vertexCopy,
+		const EdgeFunc& func, std::vector<uint32_t>* edgeIds) {
+		Graph result;
+		const Span<Vertex> copies = result.addVertices(order.size());
+		if (order.empty()) return result;
+
+		// Edges are created and put in the out lists in out list order, then the in lists are
+		// filled by walking the original in lists. Holds position + 1 of the copy by edge id.
+		std::vector<uint32_t> edgeCopy(graph.edgeIdCount());
+		std::vector<EdgeSpec> specs;
+		for (const Vertex* vertex : order)
+			vertex->forEachOutEdge([&](const Edge& edge) {
+				if (vertexCopy[edge.to().id()] && (!func || graph::alg::followEdge(func)(edge))) {
+					specs.push_back({ copies[vertexCopy[vertex->id()] - 1], copies[vertexCopy[edge.to().id()] - 1], edge.weight(), edge.layer() });
+					edgeCopy[edge.id()] = static_cast<uint32_t>(specs.size());
+					if (edgeIds) (*edgeIds)[edge.id()] = static_cast<uint32_t>(specs.size() - 1);
+				}
+			});
+		if (specs.empty()) return result;
+		result.allocated_edges.reserve(specs.size());
+		Edge* first = result.allocated_edges.next();
+		for (const EdgeSpec& spec : specs) linkOut(result.adopt(result.allocated_edges.emplace_back(spec.from, spec.to, spec.weight, spec.layer)));
+		for (const Vertex* vertex : order)
+			vertex->forEachInEdge([&](const Edge& edge) {
+				if (const uint32_t copy = edgeCopy[edge.id()]) linkIn(first[copy - 1]);
+			});
+		return result;
+	}
+
+	Relayout Graph::relayout(const VertexBindingVec& order) {
+		const auto count = std::distance(active_vertices.begin(), active_vertices.end());
+		if (order.size() != static_cast<size_t>(count)) throw std::invalid_argument("graph::core::Graph::relayout: order is not a permutation of the vertices");
+
+		Graph result;
+		Relayout moved{ {}, std::vector<uint32_t>(m_vertexIds, Relayout::noId), std::vector<uint32_t>(m_edgeIds, Relayout::noId) };
+		std::vector<uint32_t> positions;
+		{
+			// Position + 1 in order by vertex id. A vertex of another graph can share an id with
+			// one of ours, so each of ours must also be the one found at its position.
+			std::vector<uint32_t> position(m_vertexIds);
+			std::vector<const Vertex*> vertices;
+			vertices.reserve(order.size());
+			for (const auto& ref : order) {
+				const uint32_t id = ref.ptr()->id();
+				if (id >= position.size()) throw std::invalid_argument("graph::core::Graph::relayout: vertex of another graph");
+				if (position[id]) throw std::invalid_argument("graph::core::Graph::relayout: vertex listed twice");
+				vertices.push_back(ref.ptr());
+				position[id] = static_cast<uint32_t>(vertices.size());
+			}
+			for (const Vertex& vertex : active_vertices) {
+				const uint32_t at = position[vertex.id()];
+				if (!at || vertices[at - 1] != &vertex) throw std::invalid_argument("graph::core::Graph::relayout: order leaves out a vertex");
+				positions.push_back(at - 1);
+				moved.vertexIds[vertex.id()] = positions.back();
+			}
+			result = copy(*this, vertices, position, nullptr, &moved.edgeIds);
+		}
+		std::vector<Vertex*> copies;
+		for (Vertex& vertex : result.active_vertices) copies.push_back(&vertex);
+		moved.vertices.reserve(positions.size());
+		for (const uint32_t i : positions) moved.vertices.push_back(copies[i]);
+		swap(result);
+		return moved;
+	}
+
 	Vertex& Graph::newVertex() {
-		auto iter = allocated_vertices.emplace(allocated_vertices.end(), *this);
-		return *iter;
+		return adopt(allocated_vertices.emplace_back());
+	}
+
+	Edge& Graph::newEdge(Vertex& from, Vertex& to, int weight, unsigned layer) {
+		if (layer >= edgeLayers) throw std::invalid_argument("graph::core::Graph::newEdge: no layer " + std::to_string(layer));
+		Edge& edge = adopt(allocated_edges.emplace_back(from, to, weight, layer));
+		linkOut(edge);
+		linkIn(edge);
+		return edge;
 	}
 
-	Edge& Graph::newEdge(Vertex& from, Vertex& to, int weight) {
-		return allocated_edges.emplace_back(*this, from, to, weight);
+	void Graph::reserve(size_t vertices, size_t edges) {
+		if (vertices) allocated_vertices.reserve(vertices);
+		if (edges) allocated_edges.reserve(edges);
+	}
+
+	Span<Vertex> Graph::addVertices(size_t count) {
+		if (!count) return {};
+		allocated_vertices.reserve(count);
+		Vertex* first = allocated_vertices.next();
+		for (size_t i = 0; i < count; i++) adopt(allocated_vertices.emplace_back());
+		return { first, count };
+	}
+
+	Span<Edge> Graph::addEdges(const EdgeSpec* specs, size_t count, unsigned threads) {
+		if (!count) return {};
+		for (size_t i = 0; i < count; i++)
+			if (specs[i].layer >= edgeLayers) throw std::invalid_argument("graph::core::Graph::addEdges: no layer " + std::to_string(specs[i].layer));
+		allocated_edges.reserve(count);
+		Edge* first = allocated_edges.next();
+		for (size_t i = 0; i < count; i++)
+			adopt(allocated_edges.emplace_back(specs[i].from, specs[i].to, specs[i].weight, specs[i].layer));
+		const Span<Edge> edges(first, count);
+		link(&edges, 1, threads);
+		return edges;
+	}
+
+	bool Graph::linkable(Edge& edge) {
+		// An endpoint removed before linking takes its pending edges with it
+		if (!edge.m_from.linked() || !edge.m_to.linked()) edge.m_removed = true;
+		return !edge.m_removed;
+	}
+
+	void Graph::link(const Span<Edge>* runs, size_t count, unsigned threads) {
+		threads = std::max(1u, threads);
+		if (threads == 1) {
+			for (size_t r = 0; r < count; r++)
+				for (Edge& edge : runs[r])
+					if (linkable(edge)) {
+						linkOut(edge);
+						linkIn(edge);
+					}
+			return;
+		}
+
+		// A vertex belongs to one thread, which appends to its lists in run order. First every
+		// thread sorts a contiguous share of the edges into one bucket per owner, then every
+		// owner links its buckets in share order, so each edge is touched once per list.
+		auto owner = [threads](const Vertex& vertex) {
+			return static_cast<unsigned>((reinterpret_cast<uintptr_t>(&vertex) / sizeof(Vertex)) % threads);
+		};
+		std::vector<size_t> starts{ 0 };
+		for (size_t r = 0; r < count; r++) starts.push_back(starts.back() + runs[r].size());
+		const size_t total = starts.back();
+		std::vector<std::vector<Edge*>> outBuckets(threads * threads), inBuckets(threads * threads);
+		auto sort = [&](unsigned self) {
+			const size_t begin = total * self / threads, end = total * (self + 1) / threads;
+			size_t r = std::upper_bound(starts.begin(), starts.end(), begin) - starts.begin() - 1;
+			for (size_t i = begin; i < end; i++) {
+				while (i >= starts[r + 1]) r++;
+				Edge& edge = runs[r][i - starts[r]];
+				if (!linkable(edge)) continue;
+				outBuckets[self * threads + owner(edge.m_from)].push_back(&edge);
+				inBuckets[self * threads + owner(edge.m_to)].push_back(&edge);
+			}
+		};
+		auto work = [&](unsigned self) {
+			for (unsigned share = 0; share < threads; share++) {
+				for (Edge* edge : outBuckets[share * threads + self]) linkOut(*edge);
+				for (Edge* edge : inBuckets[share * threads + self]) linkIn(*edge);
+			}
+		};
+		for (const auto& phase : { std::function<void(unsigned)>(sort), std::function<void(unsigned)>(work) }) {
+			std::vector<std::thread> workers;
+			for (unsigned t = 1; t < threads; t++) workers.emplace_back(phase, t);
+			phase(0);
+			for (auto& worker : workers) worker.join();
+		}
 	}
-}
\ No newline at end of file
+}
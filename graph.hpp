@@ -1,16 +1,26 @@
 #pragma once
+#include "arena.hpp"
 #include "list.hpp"
 
 #include <functional>
-#include <list>
 #include <map>
 #include <memory>
+#include <tuple>
+#include <vector>
 namespace graph::core
 {
 	struct Forward;
 	struct Reverse;
 	class Graph;
 	class Vertex;
+	constexpr unsigned edgeLayers = 8;  // Layer ids are 0..edgeLayers-1
+#ifdef GRAPH_INLINE_OUT_EDGES
+	constexpr unsigned inlineOutEdges = 4;  // Out edges a Vertex keeps pointers to in itself, see Vertex
+#endif
+
+	// Bit l selects layer l
+	using LayerSet = uint32_t;
+	constexpr LayerSet allLayers = (1u << edgeLayers) - 1;
 
 	template <typename T>
 	class Ref {
@@ -20,70 +30,285 @@ namespace graph::core
 		Ref() = default;
 		Ref(T& ref)
 			: pointer(std::addressof(ref)) {}
-		operator T& () { return *pointer; }
+		operator T& () const { return *pointer; }
 		T* ptr() const { return pointer; }
 		constexpr bool operator<(const Ref& rhs) const { return pointer < rhs.pointer; }
 		constexpr bool operator==(const Ref& rhs) const { return pointer == rhs.pointer; }
 	};
 
+	// Contiguous run of objects owned by a Graph
+	template <typename T>
+	class Span {
+		T* m_begin = nullptr;
+		T* m_end = nullptr;
+
+	public:
+		Span() = default;
+		Span(T* begin, size_t size)
+			: m_begin(begin)
+			, m_end(begin + size) {}
+		T* begin() const { return m_begin; }
+		T* end() const { return m_end; }
+		size_t size() const { return m_end - m_begin; }
+		bool empty() const { return m_begin == m_end; }
+		T& operator[](size_t i) const { return m_begin[i]; }
+	};
+
+	// Vertices and edges do not point back to their Graph, so moving or swapping a Graph
+	// leaves them valid
 	class Edge : public list_element<Forward>, public list_element<Reverse> {
-		Graph& m_graph;
 		Vertex& m_from;
 		Vertex& m_to;
 		int m_weight;
+		uint32_t m_id = 0;
+		uint8_t m_layer;
+		bool m_outLinked = false;  // Counted in the out degree of m_from
+		bool m_removed = false;  // Keeps an edge removed before it was linked out of the lists, see GraphBuilder
 		friend class Vertex;
 		friend class Graph;
 
 	public:
-		Edge(Graph& graph, Vertex& from, Vertex& to, int weight);
+		Edge(Vertex& from, Vertex& to, int weight, unsigned layer = 0);  // Not linked into the vertices yet
 		~Edge() = default;
 		void remove();
 		const Vertex& from() const;
 		const Vertex& to() const;
 		int weight() const;
+		void setWeight(int weight) { m_weight = weight; }
+		uint32_t id() const { return m_id; }
+		unsigned layer() const { return m_layer; }
 	};
 
+	// Edges of layer 0 are in inEdges()/outEdges(), which the algorithms walk by default. Other
+	// layers have lists of their own, so a traversal of one kind of edge never scans the rest.
+	// Built with GRAPH_INLINE_OUT_EDGES, a vertex also keeps an array of pointers to its layer 0
+	// out edges, in the vertex itself up to inlineOutEdges and in one heap chunk beyond, and
+	// forEachOutEdge() scans that instead of chasing list links. It costs 32 bytes per vertex
+	// and a scan of the array per removed edge; it pays off when edges are scattered in memory.
 	class Vertex : public list_element<> {
-		Graph& m_graph;
+		struct Layers {
+			intrusive_list<Edge, Reverse> in[edgeLayers - 1];
+			intrusive_list<Edge, Forward> out[edgeLayers - 1];
+		};
 		intrusive_list<Edge, Reverse> m_in;
 		intrusive_list<Edge, Forward> m_out;
+		std::unique_ptr<Layers> m_layers;  // Layers 1 and up, made by the first edge there
+		uint32_t m_id = 0;
+		uint32_t m_outDegree = 0;  // Of m_out, fills what would be padding after m_id
+#ifdef GRAPH_INLINE_OUT_EDGES
+		union {
+			const Edge* m_inline[inlineOutEdges] = {};  // While m_outDegree <= inlineOutEdges
+			struct {
+				const Edge** edges;
+				uint32_t capacity;
+			} m_chunk;  // Otherwise
+		};
+		const Edge* const* outIndex() const { return m_outDegree <= inlineOutEdges ? m_inline : m_chunk.edges; }
+		void dropOutIndex();
+#endif
 		friend class Graph;
 		friend class Edge;
 
+		Layers& layers() {
+			if (!m_layers) m_layers = std::make_unique<Layers>();
+			return *m_layers;
+		}
+		intrusive_list<Edge, Reverse>& in(unsigned layer) { return layer ? layers().in[layer - 1] : m_in; }
+		intrusive_list<Edge, Forward>& out(unsigned layer) { return layer ? layers().out[layer - 1] : m_out; }
+		void appendOut(Edge& edge);
+		void eraseOut(Edge& edge);
+
 	public:
-		Vertex(Graph& graph);
+		Vertex() = default;
+#ifdef GRAPH_INLINE_OUT_EDGES
+		~Vertex() { dropOutIndex(); }
+#else
 		~Vertex() = default;
+#endif
 		void removeEdges();
 		void remove();
 		const intrusive_list<Edge, Reverse>& inEdges() const { return m_in; }
 		const intrusive_list<Edge, Forward>& outEdges() const { return m_out; }
+		// Throw std::invalid_argument for a layer past edgeLayers, as does forEachOutEdge(layer, f)
+		const intrusive_list<Edge, Reverse>& inEdges(unsigned layer) const;
+		const intrusive_list<Edge, Forward>& outEdges(unsigned layer) const;
+		uint32_t id() const { return m_id; }
+		uint32_t outDegree() const { return m_outDegree; }  // Of layer 0
+
+		// Calls f(edge) for the edges of one layer, in list order. f must not remove edges of
+		// the vertex.
+		template <typename F>
+		void forEachOutEdge(unsigned layer, F&& f) const {
+#ifdef GRAPH_INLINE_OUT_EDGES
+			if (!layer) {
+				const Edge* const* edges = outIndex();
+				for (uint32_t i = 0; i < m_outDegree; i++) f(*edges[i]);
+				return;
+			}
+#endif
+			for (const Edge& edge : layer ? outEdges(layer) : m_out) f(edge);
+		}
+
+		// Calls f(edge) for the edges of the layers in the set, layer by layer
+		template <typename F>
+		void forEachOutEdgeIn(LayerSet layers, F&& f) const {
+			for (unsigned layer = 0; layer < edgeLayers; layer++)
+				if (layers >> layer & 1) forEachOutEdge(layer, f);
+		}
+
+		// Calls f(edge) for the edges of every layer, layer by layer
+		template <typename F>
+		void forEachInEdge(F&& f) const {
+			for (const Edge& edge : m_in) f(edge);
+			if (m_layers)
+				for (const auto& list : m_layers->in)
+					for (const Edge& edge : list) f(edge);
+		}
+		template <typename F>
+		void forEachOutEdge(F&& f) const {
+			forEachOutEdge(0, f);
+			if (m_layers)
+				for (const auto& list : m_layers->out)
+					for (const Edge& edge : list) f(edge);
+		}
+	};
+
+	template <typename T>
+	using VertexBindingMap = std::map<Ref<const Vertex>, T>;
+
+	template <typename T>
+	using EdgeBindingMap = std::map<Ref<const Edge>, T>;
+
+	using VertexBindingVec = std::vector<Ref<const Vertex>>;
+
+	using EdgeFunc = std::function<bool(const Edge&)>;
+	using VertexFunc = std::function<bool(const Vertex&)>;
+
+	struct EdgeSpec {
+		Ref<Vertex> from;
+		Ref<Vertex> to;
+		int weight;
+		unsigned layer = 0;
+	};
+
+	// What Graph::relayout() moved where. The id maps are indexed by the old Vertex::id() and
+	// Edge::id() and hold the new one, or noId for an id no element had.
+	struct Relayout {
+		static constexpr uint32_t noId = UINT32_MAX;
+		std::vector<Vertex*> vertices;  // New copy of the i-th vertex of the old vertices()
+		std::vector<uint32_t> vertexIds;
+		std::vector<uint32_t> edgeIds;
 	};
 
 	class Graph {
 	protected:
-		std::list<Vertex> allocated_vertices;
-		std::list<Edge> allocated_edges;
+		arena<Vertex> allocated_vertices;
+		arena<Edge> allocated_edges;
 		intrusive_list<Vertex> active_vertices;
+		uint32_t m_vertexIds = 0;
+		uint32_t m_edgeIds = 0;
 		friend class Vertex;
 		friend class Edge;
+		friend class GraphBuilder;
+
+		// Number a new vertex and add it to vertices(), number a new edge
+		Vertex& adopt(Vertex& vertex) {
+			vertex.m_id = m_vertexIds++;
+			active_vertices.push_back(vertex);
+			return vertex;
+		}
+		Edge& adopt(Edge& edge) {
+			edge.m_id = m_edgeIds++;
+			return edge;
+		}
+		// Shift the ids of the elements in these arenas of a graph about to be absorbed past ours
+		template <typename V, typename E>
+		void shiftIds(arena<V>& vertices, arena<E>& edges) const {
+			vertices.for_each_run([this](V* first, size_t count) {
+				for (size_t i = 0; i < count; i++) first[i].m_id += m_vertexIds;
+			});
+			edges.for_each_run([this](E* first, size_t count) {
+				for (size_t i = 0; i < count; i++) first[i].m_id += m_edgeIds;
+			});
+		}
+		// Append edges to the out list of their from vertex and the in list of their to vertex
+		static void linkOut(Edge& edge) { edge.m_from.appendOut(edge); }
+		static void linkIn(Edge& edge) { edge.m_to.in(edge.m_layer).push_back(edge); }
+		// Append every edge of the runs to its vertices' lists, in order, except removed ones and
+		// those with an endpoint no longer in vertices(), which linkable() marks removed
+		static bool linkable(Edge& edge);
+		static void link(const Span<Edge>* runs, size_t count, unsigned threads);
+		// Copy of the vertices of order, all of graph, and of the followed edges between them.
+		// vertexCopy holds the position + 1 in order of every vertex id, 0 for vertices left out.
+		// Edges are stored and listed source by source in that order, in lists kept in their
+		// original order. edgeIds, if given, gets the new id of each copied edge at its old id.
+		static Graph copy(const Graph& graph, const std::vector<const Vertex*>& order, const std::vector<uint32_t>& vertexCopy,
+			const EdgeFunc& func, std::vector<uint32_t>* edgeIds = nullptr);
 
 	public:
 		Graph() = default;
 		~Graph();
 		Graph(const Graph&) = delete;
-		Graph(Graph&&) = default;
+		Graph(Graph&&) noexcept = default;
+		Graph& operator=(Graph&& other) noexcept;
+		void swap(Graph& other) noexcept;
+
+		// Take over all vertices and edges of other, leaving it empty. Its vertices follow the
+		// existing ones in vertices() and references to them stay valid. Storage is spliced in
+		// constant time, but shifting the ids of the absorbed elements past the existing ones
+		// makes the whole call linear in the size of other. That pass is kept on purpose: ids
+		// stored in the elements keep id() a single load, where a lazy per-run offset would
+		// add a lookup to every id() read by the algorithms. Absorbing itself does nothing.
+		void absorb(Graph&& other) noexcept;
 		Vertex& newVertex();
-		Edge& newEdge(Vertex& from, Vertex& to, int weight);
+		Edge& newEdge(Vertex& from, Vertex& to, int weight, unsigned layer = 0);  // Throws std::invalid_argument for a layer past edgeLayers
 		const intrusive_list<Vertex>& vertices() const { return active_vertices; }
-	};
 
-	template <typename T>
-	using VertexBindingMap = std::map<Ref<const Vertex>, T>;
+		// Calls f(edge) for every out edge of every vertex, vertex by vertex and layer by layer,
+		// to update edges in place, e.g. setWeight(). f must not add or remove edges.
+		template <typename F>
+		void forEachEdge(F&& f) {
+			for (Vertex& vertex : active_vertices) {
+				for (Edge& edge : vertex.m_out) f(edge);
+				if (vertex.m_layers)
+					for (auto& list : vertex.m_layers->out)
+						for (Edge& edge : list) f(edge);
+			}
+		}
 
-	template <typename T>
-	using EdgeBindingMap = std::map<Ref<const Edge>, T>;
+		// Vertex::id() and Edge::id() are dense in creation order, ids of removed elements are
+		// not reused. These bound the ids handed out so far, e.g. to size attribute columns.
+		uint32_t vertexIdCount() const { return m_vertexIds; }
+		uint32_t edgeIdCount() const { return m_edgeIds; }
 
-	using VertexBindingVec = std::vector<Ref<const Vertex>>;
+		// Make room for this many more vertices and edges in single allocations
+		void reserve(size_t vertices, size_t edges);
 
-	using EdgeFunc = std::function<bool(const Edge&)>;
+		// Bulk insertion. addEdges() keeps the order of specs in every in/out list; with
+		// threads > 1 the lists are linked concurrently, each thread owning a share of the vertices.
+		Span<Vertex> addVertices(size_t count);
+		Span<Edge> addEdges(const EdgeSpec* specs, size_t count, unsigned threads = 1);
+		Span<Edge> addEdges(const std::vector<EdgeSpec>& specs, unsigned threads = 1) { return addEdges(specs.data(), specs.size(), threads); }
+
+		// Rebuild the storage with vertices in the given order, a permutation of vertices(), and
+		// all edges in one run grouped by source in that order, so neighbors in that order are
+		// close in memory. In and out lists keep their order. Ids are renumbered to the new order;
+		// AttributeStore::remap() moves columns along. References to
+		// the old vertices and edges become invalid. Throws std::invalid_argument if order is not
+		// a permutation of vertices().
+		Relayout relayout(const VertexBindingVec& order);
+
+		// Reads the graph only, so safe to run concurrently with other readers
+		Graph clone() const;
+		friend std::tuple<Graph, std::vector<Vertex*>> extractSubgraph(const Graph& graph, const VertexFunc& keep, const EdgeFunc& func);
+	};
+
+	// Copy of the vertices accepted by keep and the followed edges between them, with in and out
+	// lists in their original order. Followed means what it does for the algorithms, a nonzero
+	// weight and accepted by func; a null func copies every edge. Linear time, with work arrays
+	// indexed by id, so graph is only read. Element i of the vector is the copy of the i-th
+	// vertex of graph.vertices(), or null if it was left out.
+	std::tuple<Graph, std::vector<Vertex*>> extractSubgraph(const Graph& graph, const VertexFunc& keep, const EdgeFunc& func);
+
+	inline void swap(Graph& a, Graph& b) noexcept { a.swap(b); }
 }
\ No newline at end of file
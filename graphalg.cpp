@@ -1,45 +1,50 @@
 #include "graphalg.hpp"
+#include "csr.hpp"
+#include "edgemask.hpp"
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <thread>
 
 using namespace graph::core;
 
-auto followEdge(const EdgeFunc& func)
-{
-	return [&func](const Edge& edge) {
-		return edge.weight() && func(edge);
-	};
-}
+using graph::alg::followEdge;
 
+// The traversals are templates over the edge test, so EdgeMask overloads skip the std::function
 namespace scc
 {
+	template <typename Follow>
 	void vertexIterate(
 		const Vertex& vertex,
-		const EdgeFunc& func,
+		const Follow& func,
+		const LayerSet layers,
 		uint32_t& currentDfs,
-		VertexBindingMap<uint32_t>& user,
-		VertexBindingMap<uint32_t>& color,
+		std::vector<uint32_t>& user,
+		std::vector<uint32_t>& color,
 		std::vector<Ref<const Vertex>>& callTrace)
 	{
 		const uint32_t thisDfsNum = currentDfs++;
-		user[vertex] = thisDfsNum;
-		color[vertex] = 0;
-		for (const Edge& edge : vertex.outEdges()) {
+		const uint32_t id = vertex.id();
+		user[id] = thisDfsNum;
+		color[id] = 0;
+		vertex.forEachOutEdgeIn(layers, [&](const Edge& edge) {
 			if (func(edge)) {
-				const Vertex& to = edge.to();
+				const uint32_t to = edge.to().id();
 				if (!user[to]) {  // Dest not computed yet
-					vertexIterate(to, func, currentDfs, user, color, callTrace);
+					vertexIterate(edge.to(), func, layers, currentDfs, user, color, callTrace);
 				}
 				if (!color[to]) {  // Dest not in a component
-					user[vertex] = std::min(user[vertex], user[to]);
+					user[id] = std::min(user[id], user[to]);
 				}
 			}
-		}
-		if (user[vertex] == thisDfsNum) {  // New head of subtree
-			color[vertex] = thisDfsNum;  // Mark as component
+		});
+		if (user[id] == thisDfsNum) {  // New head of subtree
+			color[id] = thisDfsNum;  // Mark as component
 			while (!callTrace.empty()) {
-				const Vertex& popVertex = callTrace.back();
-				if (user[popVertex] >= thisDfsNum) {  // Lower node is part of this subtree
+				const uint32_t pop = callTrace.back().ptr()->id();
+				if (user[pop] >= thisDfsNum) {  // Lower node is part of this subtree
 					callTrace.pop_back();
-					color[popVertex] = thisDfsNum;
+					color[pop] = thisDfsNum;
 				}
 				else {
 					break;
@@ -50,58 +55,230 @@ namespace scc
 			callTrace.push_back(vertex);
 		}
 	}
+
+	template <typename Follow>
+	VertexBindingMap<uint32_t> colorGraph(const Graph& graph, const Follow& followEdgeFunc, const LayerSet layers)
+	{
+		// Use Tarjan's algorithm to find the strongly connected subgraphs.
+		// State, indexed by vertex id:
+		//     user     // DFS number indicating possible root of subtree, 0=not iterated
+		//     color       // Output subtree number (fully processed)
+		std::vector<uint32_t> color(graph.vertexIdCount()), user(graph.vertexIdCount());
+		uint32_t currentDfs = 0;
+		std::vector<Ref<const Vertex>> callTrace;  // List of everything we hit processing so far
+
+		// Color graph
+		for (const Vertex& vertex : graph.vertices()) {
+			if (!user[vertex.id()]) {
+				currentDfs++;
+				vertexIterate(vertex, followEdgeFunc, layers, currentDfs, user, color, callTrace);
+			}
+		}
+
+		// If there's a single vertex of a color, it doesn't need a subgraph
+		// This simplifies the consumer's code, and reduces graph debugging clutter
+		VertexBindingMap<uint32_t> result;
+		for (const Vertex& vertex : graph.vertices()) {
+			const uint32_t own = color[vertex.id()];
+			bool onecolor = true;
+			vertex.forEachOutEdgeIn(layers, [&](const Edge& edge) {
+				if (onecolor && followEdgeFunc(edge) && own == color[edge.to().id()]) onecolor = false;
+			});
+			result.emplace(vertex, onecolor ? 0 : own);
+		}
+
+		return result;
+	}
+
+	// Iterative Tarjan over the snapshot, returns the component of each vertex
+	std::vector<uint32_t> components(const graph::alg::CsrGraph& csr, uint32_t& count)
+	{
+		const uint32_t size = csr.vertexCount();
+		std::vector<uint32_t> index(size, UINT32_MAX), low(size), component(size);
+		std::vector<bool> onStack(size, false);
+		std::vector<uint32_t> stack;
+		std::vector<std::pair<uint32_t, uint32_t>> frames;  // Vertex and next out edge to visit
+		uint32_t counter = 0;
+		count = 0;
+		auto visit = [&](uint32_t v) {
+			index[v] = low[v] = counter++;
+			stack.push_back(v);
+			onStack[v] = true;
+			frames.emplace_back(v, 0);
+		};
+		for (uint32_t root = 0; root < size; root++) {
+			if (index[root] != UINT32_MAX) continue;
+			visit(root);
+			while (!frames.empty()) {
+				const uint32_t v = frames.back().first;
+				const auto targets = csr.outTargets(v);
+				if (frames.back().second < targets.size()) {
+					const uint32_t w = targets[frames.back().second++];
+					if (index[w] == UINT32_MAX) visit(w);
+					else if (onStack[w]) low[v] = std::min(low[v], index[w]);
+					continue;
+				}
+				if (low[v] == index[v]) {
+					uint32_t w;
+					do {
+						w = stack.back();
+						stack.pop_back();
+						onStack[w] = false;
+						component[w] = count;
+					} while (w != v);
+					count++;
+				}
+				frames.pop_back();
+				if (!frames.empty()) low[frames.back().first] = std::min(low[frames.back().first], low[v]);
+			}
+		}
+		return component;
+	}
+}
+
+namespace wcc
+{
+	// Lock-free disjoint set, roots are always linked under the smaller index
+	// so parent[x] <= x holds and concurrent path halving can never form a cycle
+	class UnionFind {
+		std::vector<std::atomic<uint32_t>> parent;
+
+	public:
+		explicit UnionFind(uint32_t size)
+			: parent(size) {
+			for (uint32_t i = 0; i < size; i++) parent[i].store(i, std::memory_order_relaxed);
+		}
+		uint32_t find(uint32_t x) {
+			while (true) {
+				uint32_t p = parent[x].load(std::memory_order_acquire);
+				if (p == x) return x;
+				const uint32_t gp = parent[p].load(std::memory_order_acquire);
+				if (p != gp) parent[x].compare_exchange_weak(p, gp, std::memory_order_release, std::memory_order_relaxed);  // Path halving
+				x = gp;
+			}
+		}
+		void unite(uint32_t a, uint32_t b) {
+			while (true) {
+				a = find(a);
+				b = find(b);
+				if (a == b) return;
+				if (a < b) std::swap(a, b);
+				uint32_t expected = a;
+				if (parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+			}
+		}
+	};
+
+	constexpr size_t minEdgesPerThread = 1 << 14;
+
+	// Unites the endpoints of every out edge of the snapshot. Threads take equal runs of the
+	// out rows, each starting at the row its first edge is in.
+	void uniteAll(UnionFind& sets, const graph::alg::CsrGraph& csr)
+	{
+		const auto& rows = csr.arrays();
+		const size_t edges = rows.edgeCount;
+		const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+		const size_t nthreads = std::min(hw, edges / minEdgesPerThread + 1);
+		auto work = [&](size_t begin, size_t end) {
+			const uint32_t* offsets = rows.outOffsets;
+			uint32_t from = static_cast<uint32_t>(std::upper_bound(offsets, offsets + rows.vertexCount + 1, begin) - offsets - 1);
+			for (size_t e = begin; e < end; e++) {
+				while (offsets[from + 1] <= e) from++;
+				sets.unite(from, rows.outTargets[e]);
+			}
+		};
+		const size_t chunk = (edges + nthreads - 1) / nthreads;
+		std::vector<std::thread> threads;
+		for (size_t t = 1; t < nthreads; t++)
+			threads.emplace_back(work, std::min(edges, t * chunk), std::min(edges, (t + 1) * chunk));
+		work(0, std::min(edges, chunk));
+		for (auto& thread : threads) thread.join();
+	}
 }
 
 namespace report
 {
+	template <typename Follow>
 	bool vertexIterate(const Vertex& vertex,
-		const EdgeFunc& func,
+		const Follow& func,
+		const LayerSet layers,
 		VertexBindingVec& callTrace,
-		VertexBindingMap<uint32_t>& visited) {
+		std::vector<uint8_t>& visited) {
 		callTrace.push_back(vertex);
-		if (visited[vertex] == 1) return true;
-		if (visited[vertex] == 2) {
+		const uint32_t id = vertex.id();
+		if (id >= visited.size()) visited.resize(id + 1);  // No graph at hand, so grow by id
+		if (visited[id] == 1) return true;
+		if (visited[id] == 2) {
 			callTrace.pop_back();
 			return false;  // Already processed it
 		}
-		visited[vertex] = 1;
-		for (const auto& edge : vertex.outEdges()) {
-			if (func(edge) && vertexIterate(edge.to(), func, callTrace, visited))
-				return true;
-		}
-		visited[vertex] = 2;
+		visited[id] = 1;
+		bool found = false;
+		vertex.forEachOutEdgeIn(layers, [&](const Edge& edge) {
+			if (!found && func(edge)) found = vertexIterate(edge.to(), func, layers, callTrace, visited);
+		});
+		if (found) return true;
+		visited[id] = 2;
 		callTrace.pop_back();
 		return false;
 	}
+
+	template <typename Follow>
+	VertexBindingVec loops(const Vertex& vertex, const Follow& func, const LayerSet layers)
+	{
+		VertexBindingVec callTrace;
+		std::vector<uint8_t> visited;
+		vertexIterate(vertex, func, layers, callTrace, visited);
+		return callTrace;
+	}
 }
 
 namespace ranking
 {
+	template <typename Follow>
 	void vertexIterate(
 		const Vertex& vertex,
-		const EdgeFunc& func,
+		const Follow& func,
+		const LayerSet layers,
 		const uint32_t adder,
 		const uint32_t currentRank,
-		VertexBindingMap<uint32_t>& visited,
-		VertexBindingMap<uint32_t>& rank,
+		std::vector<uint8_t>& visited,
+		std::vector<uint32_t>& rank,
 		VertexBindingMap<VertexBindingVec>& loopsMap)
 	{
 		// Assign rank to each unvisited node
 		// If larger rank is found, assign it and loop back through
 		// If we hit a back node make a list of all loops
-		if (visited[vertex] == 1) {
-			loopsMap[vertex] = graph::alg::reportLoops(vertex, func);
+		if (visited[vertex.id()] == 1) {
+			loopsMap[vertex] = report::loops(vertex, func, layers);
 			return;
 		}
 
-		if (rank[vertex] >= currentRank) return;  // Already processed it
-		visited[vertex] = 1;
-		rank[vertex] = currentRank;
-		for (const auto& edge : vertex.outEdges()) {
+		if (rank[vertex.id()] >= currentRank) return;  // Already processed it
+		visited[vertex.id()] = 1;
+		rank[vertex.id()] = currentRank;
+		vertex.forEachOutEdgeIn(layers, [&](const Edge& edge) {
 			if (func(edge))
-				vertexIterate(edge.to(), func, adder, currentRank + adder, visited, rank, loopsMap);
-		}
-		visited[vertex] = 2;
+				vertexIterate(edge.to(), func, layers, adder, currentRank + adder, visited, rank, loopsMap);
+		});
+		visited[vertex.id()] = 2;
+	}
+
+	template <typename Follow>
+	std::tuple<VertexBindingMap<uint32_t>, VertexBindingMap<VertexBindingVec>>
+	ranks(const Graph& graph, const Follow& func, const uint32_t adder, const LayerSet layers)
+	{
+		VertexBindingMap<VertexBindingVec> loopsMap;
+		// Indexed by vertex id, so concurrent calls on one graph stay safe
+		std::vector<uint8_t> visited(graph.vertexIdCount());
+		std::vector<uint32_t> rank(graph.vertexIdCount());
+		for (const Vertex& vertex : graph.vertices())
+			if (!visited[vertex.id()]) {
+				vertexIterate(vertex, func, layers, adder, 1, visited, rank, loopsMap);
+			}
+		VertexBindingMap<uint32_t> result;
+		for (const Vertex& vertex : graph.vertices()) result.emplace(vertex, rank[vertex.id()]);
+		return { result, loopsMap };
 	}
 }
 
@@ -127,10 +304,11 @@ namespace acy
 		Graph& breakGraph,
 		VertexBindingMap<uint32_t>& color,
 		VertexBindingMap<Ref<Vertex>>& Acyc,
-		const EdgeFunc& func)
+		const EdgeFunc& func,
+		const LayerSet layers)
 	{
 		// Make new edges
-		for (const Edge& edge : overtex.outEdges()) {
+		overtex.forEachOutEdgeIn(layers, [&](const Edge& edge) {
 			if (func(edge)) {  // not cut
 				const Vertex& toVertex = edge.to();
 				if (color[toVertex]) {
@@ -142,10 +320,10 @@ namespace acy
 					addOrigEdge(breakEdge, edge);  // So can find original edge
 				}
 			}
-		}
+		});
 	}
 
-	Graph buildGraph(const Graph& graph, VertexBindingMap<uint32_t>& color, const EdgeFunc& func)
+	Graph buildGraph(const Graph& graph, VertexBindingMap<uint32_t>& color, const EdgeFunc& func, const LayerSet layers)
 	{
 		VertexBindingMap<Ref<Vertex>> Acyc;
 		Graph breakGraph;
@@ -158,7 +336,7 @@ namespace acy
 		// Build edges between logic vertices
 		for (const Vertex& overtex : graph.vertices())
 			if (color[overtex]) {
-				buildGraphIterate(overtex, Acyc[overtex], breakGraph, color, Acyc, followEdge(func));
+				buildGraphIterate(overtex, Acyc[overtex], breakGraph, color, Acyc, followEdge(func), layers);
 			}
 		return breakGraph;
 	}
@@ -175,68 +353,91 @@ namespace acy
 namespace graph::alg
 {
 
-	VertexBindingMap<uint32_t> strongly(const Graph& graph, EdgeFunc func)
+	VertexBindingMap<uint32_t> strongly(const Graph& graph, EdgeFunc func, LayerSet layers)
 	{
-		// Use Tarjan's algorithm to find the strongly connected subgraphs.
-		// State:
-		//     user     // DFS number indicating possible root of subtree, 0=not iterated
-		//     color       // Output subtree number (fully processed)
-		VertexBindingMap<uint32_t> color, user;
-		uint32_t currentDfs = 0;
-		std::vector<Ref<const Vertex>> callTrace;  // List of everything we hit processing so far
+		return scc::colorGraph(graph, followEdge(func), layers);
+	}
 
-		const auto followEdgeFunc = followEdge(func);
+	VertexBindingMap<uint32_t> strongly(const Graph& graph, const EdgeMask& mask, LayerSet layers)
+	{
+		return scc::colorGraph(graph, followEdge(mask), layers);
+	}
 
-		// Color graph
-		for (const Vertex& vertex : graph.vertices()) {
-			if (!user[vertex]) {
-				currentDfs++;
-				scc::vertexIterate(vertex, followEdgeFunc, currentDfs, user, color, callTrace);
-			}
-		}
+	std::tuple<VertexBindingMap<uint32_t>, std::vector<uint32_t>>
+	weaklyConnected(const Graph& graph, EdgeFunc func, LayerSet layers)
+	{
+		const CsrGraph csr(graph, followEdge(func), layers);
+		auto [ids, sizes] = weaklyConnected(csr);
+		VertexBindingMap<uint32_t> component;
+		for (uint32_t i = 0; i < csr.vertexCount(); i++) component.emplace(csr.vertex(i), ids[i]);
+		return { component, sizes };
+	}
 
-		// If there's a single vertex of a color, it doesn't need a subgraph
-		// This simplifies the consumer's code, and reduces graph debugging clutter
-		for (const Vertex& vertex : graph.vertices()) {
-			bool onecolor = true;
-			for (const Edge& edge : vertex.outEdges()) {
-				if (followEdgeFunc(edge)) {
-					if (color[vertex] == color[edge.to()]) {
-						onecolor = false;
-						break;
-					}
-				}
+	std::tuple<VertexBindingMap<uint32_t>, std::vector<uint32_t>>
+	weaklyConnected(const Graph& graph, const EdgeMask& mask, LayerSet layers)
+	{
+		// The snapshot is built in one pass, so the mask goes through func() here
+		return weaklyConnected(graph, mask.func(), layers);
+	}
+
+	std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> weaklyConnected(const CsrGraph& csr)
+	{
+		// Direction is ignored, every edge merges the sets of its endpoints
+		wcc::UnionFind sets(csr.vertexCount());
+		wcc::uniteAll(sets, csr);
+
+		// Number components in vertex order
+		constexpr uint32_t unassigned = UINT32_MAX;
+		std::vector<uint32_t> rootComponent(csr.vertexCount(), unassigned);
+		std::vector<uint32_t> component(csr.vertexCount());
+		std::vector<uint32_t> sizes;
+		for (uint32_t i = 0; i < csr.vertexCount(); i++) {
+			uint32_t& id = rootComponent[sets.find(i)];
+			if (id == unassigned) {
+				id = static_cast<uint32_t>(sizes.size());
+				sizes.push_back(0);
 			}
-			if (onecolor) color[vertex] = 0;
+			sizes[id]++;
+			component[i] = id;
 		}
+		return { component, sizes };
+	}
 
-		return color;
+	std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> stronglyConnected(const CsrGraph& csr)
+	{
+		uint32_t count;
+		std::vector<uint32_t> component = scc::components(csr, count);
+		std::vector<uint32_t> sizes(count, 0);
+		for (const uint32_t c : component) sizes[c]++;
+		return { component, sizes };
 	}
 
 	std::tuple<VertexBindingMap<uint32_t>, VertexBindingMap<VertexBindingVec>>
-	rank(const Graph& graph, EdgeFunc func, const uint32_t adder)
+	rank(const Graph& graph, EdgeFunc func, const uint32_t adder, LayerSet layers)
 	{
-		VertexBindingMap<uint32_t> rank, visited;
-		VertexBindingMap<VertexBindingVec> loopsMap;
-		for (const Vertex& vertex : graph.vertices())
-			if (!visited[vertex]) {
-				ranking::vertexIterate(vertex, followEdge(func), adder, 1, visited, rank, loopsMap);
-			}
-		return { rank, loopsMap };
+		return ranking::ranks(graph, followEdge(func), adder, layers);
 	}
 
-	void acylic(const Graph& graph, EdgeFunc func)
+	std::tuple<VertexBindingMap<uint32_t>, VertexBindingMap<VertexBindingVec>>
+	rank(const Graph& graph, const EdgeMask& mask, const uint32_t adder, LayerSet layers)
 	{
-		auto color = strongly(graph);
-		const Graph breakGraph = acy::buildGraph(graph, color, func);
+		return ranking::ranks(graph, followEdge(mask), adder, layers);
+	}
+
+	void acylic(const Graph& graph, EdgeFunc func, LayerSet layers)
+	{
+		auto color = strongly(graph, followAlwaysTrue, layers);
+		const Graph breakGraph = acy::buildGraph(graph, color, func, layers);
 		acy::simplify(breakGraph, false);
 	}
 
-	VertexBindingVec reportLoops(const Vertex& vertex, EdgeFunc func)
+	VertexBindingVec reportLoops(const Vertex& vertex, EdgeFunc func, LayerSet layers)
 	{
-		VertexBindingVec callTrace;
-		VertexBindingMap<uint32_t> visited;
-		report::vertexIterate(vertex, followEdge(func), callTrace, visited);
-		return callTrace;
+		return report::loops(vertex, followEdge(func), layers);
+	}
+
+	VertexBindingVec reportLoops(const Vertex& vertex, const EdgeMask& mask, LayerSet layers)
+	{
+		return report::loops(vertex, followEdge(mask), layers);
 	}
 }
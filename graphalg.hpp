@@ -1,18 +1,45 @@
 #pragma once
 #include <tuple>
+#include <vector>
 #include "graph.hpp"
 
 namespace graph::alg {
 	using namespace graph::core;
 
+	class CsrGraph;
+	class EdgeMask;
+
 	inline bool followAlwaysTrue(const Edge&) { return true; }
 
+	// The edges an algorithm follows: nonzero weight and accepted by func, which must outlive the result
+	inline auto followEdge(const EdgeFunc& func) {
+		return [&func](const Edge& edge) { return edge.weight() && func(edge); };
+	}
+
+	// The Graph algorithms follow the edges of the layers in layers, by default layer 0 only
+
 	// Algorithms - strongly connected components
-	VertexBindingMap<uint32_t> strongly(const Graph& graph, EdgeFunc func = followAlwaysTrue);
+	VertexBindingMap<uint32_t> strongly(const Graph& graph, EdgeFunc func = followAlwaysTrue, LayerSet layers = 1);
+	VertexBindingMap<uint32_t> strongly(const Graph& graph, const EdgeMask& mask, LayerSet layers = 1);
 
+	// Algorithms - weakly connected components
+	// Returns a dense component id (0..n-1) per vertex and the size of each component
+	std::tuple<VertexBindingMap<uint32_t>, std::vector<uint32_t>>
+	weaklyConnected(const Graph& graph, EdgeFunc func = followAlwaysTrue, LayerSet layers = 1);
+	std::tuple<VertexBindingMap<uint32_t>, std::vector<uint32_t>>
+	weaklyConnected(const Graph& graph, const EdgeMask& mask, LayerSet layers = 1);
+
+	// Snapshot variants, ids are CsrGraph ids and every edge of the snapshot is followed.
+	// Return the component of each vertex and the size of each component.
+	std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> weaklyConnected(const CsrGraph& csr);
+	std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> stronglyConnected(const CsrGraph& csr);  // In reverse topological order
+
+	std::tuple<VertexBindingMap<uint32_t> , VertexBindingMap<VertexBindingVec>>
+	rank(const Graph& graph, EdgeFunc func = followAlwaysTrue, const uint32_t adder = 1, LayerSet layers = 1);
 	std::tuple<VertexBindingMap<uint32_t> , VertexBindingMap<VertexBindingVec>>
-	rank(const Graph& graph, EdgeFunc func = followAlwaysTrue, const uint32_t adder = 1);
+	rank(const Graph& graph, const EdgeMask& mask, const uint32_t adder = 1, LayerSet layers = 1);
 
-	void acylic(const Graph& graph, EdgeFunc func = followAlwaysTrue);
-	VertexBindingVec reportLoops(const Vertex& vertex, EdgeFunc func = followAlwaysTrue);
+	void acylic(const Graph& graph, EdgeFunc func = followAlwaysTrue, LayerSet layers = 1);
+	VertexBindingVec reportLoops(const Vertex& vertex, EdgeFunc func = followAlwaysTrue, LayerSet layers = 1);
+	VertexBindingVec reportLoops(const Vertex& vertex, const EdgeMask& mask, LayerSet layers = 1);
 }
\ No newline at end of file
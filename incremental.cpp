@@ -0,0 +1,64 @@
+#include "incremental.hpp"
+
+#include <stdexcept>
+
+namespace graph::exec
+{
+	IncrementalEvaluator::IncrementalEvaluator(const Graph& graph, EdgeFunc func, LayerSet layers)
+		: m_graph(graph)
+		, m_func([func](const Edge& edge) { return edge.weight() && func(edge); })
+		, m_layers(layers)
+	{
+	}
+
+	VertexBindingVec IncrementalEvaluator::affected() const
+	{
+		// Collect the cone and count the in-cone predecessors of each member
+		VertexBindingMap<uint32_t> inDegree;
+		VertexBindingVec cone;
+		for (const auto& [vertex, unused] : m_changed) {
+			if (inDegree.emplace(vertex, 0).second) cone.push_back(vertex);
+		}
+		for (size_t head = 0; head < cone.size(); head++) {
+			const Vertex& vertex = *cone[head].ptr();
+			vertex.forEachOutEdgeIn(m_layers, [&](const Edge& edge) {
+				if (!m_func(edge)) return;
+				auto [it, inserted] = inDegree.emplace(edge.to(), 0);
+				if (inserted) cone.push_back(edge.to());
+				it->second++;
+			});
+		}
+
+		VertexBindingVec order;
+		order.reserve(cone.size());
+		for (const auto& vertex : cone)
+			if (!inDegree[vertex]) order.push_back(vertex);
+		for (size_t head = 0; head < order.size(); head++) {
+			const Vertex& vertex = *order[head].ptr();
+			vertex.forEachOutEdgeIn(m_layers, [&](const Edge& edge) {
+				if (m_func(edge) && !--inDegree[edge.to()]) order.push_back(edge.to());
+			});
+		}
+		if (order.size() != cone.size()) throw std::invalid_argument("graph::exec::IncrementalEvaluator: affected cone has a cycle");
+		return order;
+	}
+
+	size_t IncrementalEvaluator::evaluate(RecomputeFunc recompute)
+	{
+		VertexBindingVec order = affected();
+		VertexBindingMap<bool> dirty = std::move(m_changed);
+		m_changed.clear();
+		size_t executed = 0;
+		for (const auto& ref : order) {
+			auto it = dirty.find(ref);
+			if (it == dirty.end()) continue;  // Every input that reaches it stayed the same
+			const Vertex& vertex = *ref.ptr();
+			executed++;
+			if (!recompute(vertex)) continue;  // Early cutoff
+			vertex.forEachOutEdgeIn(m_layers, [&](const Edge& edge) {
+				if (m_func(edge)) dirty[edge.to()] = true;
+			});
+		}
+		return executed;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "graphalg.hpp"
+
+#include <vector>
+namespace graph::exec
+{
+	using namespace graph::core;
+
+	// Returns true if the vertex output changed, false lets evaluation stop at this vertex
+	using RecomputeFunc = std::function<bool(const Vertex&)>;
+
+	// Tracks changed vertices of a dependency Graph and re-executes only the cone they affect.
+	// The followed edges inside that cone, of the layers in layers, must be acyclic.
+	class IncrementalEvaluator {
+		const Graph& m_graph;
+		EdgeFunc m_func;
+		LayerSet m_layers;
+		VertexBindingMap<bool> m_changed;
+
+	public:
+		explicit IncrementalEvaluator(const Graph& graph, EdgeFunc func = graph::alg::followAlwaysTrue, LayerSet layers = 1);
+		void markChanged(const Vertex& vertex) { m_changed[vertex] = true; }
+		bool changed(const Vertex& vertex) const { return m_changed.count(vertex) != 0; }
+
+		// Every vertex reachable from a changed vertex, in topological order
+		// Throws std::invalid_argument if the cone has a cycle
+		VertexBindingVec affected() const;
+
+		// Recomputes changed vertices and, as long as outputs keep changing, their successors.
+		// Clears the changed set and returns how many vertices were recomputed.
+		size_t evaluate(RecomputeFunc recompute);
+	};
+}
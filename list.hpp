@@ -11,6 +11,7 @@ private:
 	list_element* prev = nullptr;
 
 public:
+	bool linked() const noexcept { return next != nullptr; }
 	void unlink() {
 		if (next != nullptr) next->prev = prev;
 		if (prev != nullptr) prev->next = next;
@@ -98,6 +99,12 @@ public:
 		return *this;
 	}
 
+	void swap(intrusive_list& r) noexcept {
+		intrusive_list tmp(std::move(r));
+		r = std::move(*this);
+		*this = std::move(tmp);
+	}
+
 	void clear() noexcept {
 		if (empty()) return;
 		// now root.next != root
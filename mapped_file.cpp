@@ -0,0 +1,47 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace graph::io
+{
+	MappedFile::MappedFile(const std::string& path)
+		: MappedFile(::open(path.c_str(), O_RDONLY), path)
+	{
+	}
+
+	MappedFile MappedFile::shared(const std::string& name)
+	{
+		return MappedFile(::shm_open(name.c_str(), O_RDONLY, 0), name);
+	}
+
+	// Takes ownership of fd
+	MappedFile::MappedFile(int fd, const std::string& name)
+	{
+		if (fd < 0) throw std::runtime_error("graph::io: " + name + ": cannot open");
+		struct stat st;
+		if (::fstat(fd, &st) != 0) {
+			::close(fd);
+			throw std::runtime_error("graph::io: " + name + ": cannot stat");
+		}
+		m_size = static_cast<size_t>(st.st_size);
+		if (m_size) {
+			void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (p == MAP_FAILED) {
+				::close(fd);
+				throw std::runtime_error("graph::io: " + name + ": cannot map");
+			}
+			m_data = static_cast<const char*>(p);
+		}
+		::close(fd);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_data) ::munmap(const_cast<char*>(m_data), m_size);
+	}
+}
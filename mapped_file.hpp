@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <string>
+namespace graph::io
+{
+	// Read only mapping of a whole file or POSIX shared memory object, empty ones map to a null pointer
+	class MappedFile {
+		const char* m_data = nullptr;
+		size_t m_size = 0;
+
+		MappedFile(int fd, const std::string& name);
+
+	public:
+		explicit MappedFile(const std::string& path);  // Throws std::runtime_error
+		static MappedFile shared(const std::string& name);  // Name as for shm_open(), e.g. "/graph"
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+	};
+}
@@ -0,0 +1,468 @@
+#include "partition.hpp"
+#include "csr.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <tuple>
+
+using namespace graph::core;
+using graph::alg::CsrGraph;
+
+namespace part
+{
+	constexpr uint32_t none = UINT32_MAX;
+
+	struct Arc {
+		uint32_t from;
+		uint32_t to;
+		uint64_t weight;
+	};
+
+	// One level of the multilevel hierarchy, parallel edges are merged and self loops dropped
+	struct Level {
+		std::vector<uint64_t> weight;  // Vertex weights
+		std::vector<uint32_t> offsets;  // Undirected adjacency, weight of both directions summed
+		std::vector<uint32_t> adj;
+		std::vector<uint64_t> adjWeight;
+		std::vector<uint32_t> outOffsets;  // Directed adjacency, rows are sorted
+		std::vector<uint32_t> out;
+		std::vector<uint64_t> outWeight;
+		std::vector<uint32_t> inOffsets;
+		std::vector<uint32_t> in;
+		std::vector<uint32_t> coarse;  // Vertex id in the next coarser level
+		uint32_t size() const { return static_cast<uint32_t>(weight.size()); }
+	};
+
+	template <typename F>
+	void forNeighbors(const Level& level, uint32_t u, F&& f) {
+		for (uint32_t i = level.offsets[u]; i < level.offsets[u + 1]; i++) f(level.adj[i], level.adjWeight[i]);
+	}
+
+	// Sort and merge arcs, returns row offsets
+	std::vector<uint32_t> mergeArcs(uint32_t size, std::vector<Arc>& arcs) {
+		std::sort(arcs.begin(), arcs.end(), [](const Arc& a, const Arc& b) {
+			return std::tie(a.from, a.to) < std::tie(b.from, b.to);
+		});
+		size_t last = 0;
+		for (size_t i = 0; i < arcs.size(); i++) {
+			if (last && arcs[last - 1].from == arcs[i].from && arcs[last - 1].to == arcs[i].to)
+				arcs[last - 1].weight += arcs[i].weight;
+			else
+				arcs[last++] = arcs[i];
+		}
+		arcs.resize(last);
+		std::vector<uint32_t> offsets(size + 1, 0);
+		for (const Arc& arc : arcs) offsets[arc.from + 1]++;
+		for (uint32_t i = 0; i < size; i++) offsets[i + 1] += offsets[i];
+		return offsets;
+	}
+
+	Level buildLevel(std::vector<uint64_t> weight, std::vector<Arc> arcs) {
+		Level level;
+		level.weight = std::move(weight);
+		const uint32_t size = level.size();
+		arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [](const Arc& arc) { return arc.from == arc.to; }), arcs.end());
+
+		level.outOffsets = mergeArcs(size, arcs);
+		for (const Arc& arc : arcs) {
+			level.out.push_back(arc.to);
+			level.outWeight.push_back(arc.weight);
+		}
+
+		std::vector<Arc> reverse;
+		reverse.reserve(arcs.size());
+		for (const Arc& arc : arcs) reverse.push_back({ arc.to, arc.from, arc.weight });
+		level.inOffsets = mergeArcs(size, reverse);
+		for (const Arc& arc : reverse) level.in.push_back(arc.to);
+
+		arcs.insert(arcs.end(), reverse.begin(), reverse.end());
+		level.offsets = mergeArcs(size, arcs);
+		for (const Arc& arc : arcs) {
+			level.adj.push_back(arc.to);
+			level.adjWeight.push_back(arc.weight);
+		}
+		return level;
+	}
+
+	// Collapse vertices with the same group id into one vertex of a new level
+	Level contract(const Level& fine, const std::vector<uint32_t>& group, uint32_t groups) {
+		std::vector<uint64_t> weight(groups, 0);
+		for (uint32_t u = 0; u < fine.size(); u++) weight[group[u]] += fine.weight[u];
+		std::vector<Arc> arcs;
+		arcs.reserve(fine.out.size());
+		for (uint32_t u = 0; u < fine.size(); u++)
+			for (uint32_t i = fine.outOffsets[u]; i < fine.outOffsets[u + 1]; i++)
+				arcs.push_back({ group[u], group[fine.out[i]], fine.outWeight[i] });
+		return buildLevel(std::move(weight), std::move(arcs));
+	}
+
+	// Kahn's algorithm, the order is shorter than the level if it has a cycle
+	std::vector<uint32_t> topoOrder(const Level& level) {
+		std::vector<uint32_t> degree(level.size());
+		std::vector<uint32_t> order;
+		order.reserve(level.size());
+		for (uint32_t u = 0; u < level.size(); u++) {
+			degree[u] = level.inOffsets[u + 1] - level.inOffsets[u];
+			if (!degree[u]) order.push_back(u);
+		}
+		for (size_t head = 0; head < order.size(); head++) {
+			const uint32_t u = order[head];
+			for (uint32_t i = level.outOffsets[u]; i < level.outOffsets[u + 1]; i++)
+				if (!--degree[level.out[i]]) order.push_back(level.out[i]);
+		}
+		return order;
+	}
+
+	bool hasArc(const Level& level, uint32_t from, uint32_t to) {
+		const auto begin = level.out.begin() + level.outOffsets[from];
+		const auto end = level.out.begin() + level.outOffsets[from + 1];
+		return std::binary_search(begin, end, to);
+	}
+
+	// Merging u->v cannot close a cycle when it is the only way out of u or into v
+	bool safeContraction(const Level& level, uint32_t u, uint32_t v) {
+		auto safe = [&level](uint32_t from, uint32_t to) {
+			return hasArc(level, from, to) &&
+				(level.outOffsets[from + 1] - level.outOffsets[from] == 1 || level.inOffsets[to + 1] - level.inOffsets[to] == 1);
+		};
+		return safe(u, v) || safe(v, u);
+	}
+
+	// Heavy-edge matching, returns false if the level did not shrink enough to be worth keeping
+	bool coarsen(Level& fine, Level& coarse, std::mt19937& rng, uint64_t maxWeight, bool acyclic) {
+		std::vector<uint32_t> order(fine.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), rng);
+		std::vector<uint32_t> match(fine.size(), none);
+		for (const uint32_t u : order) {
+			if (match[u] != none) continue;
+			uint32_t best = u;
+			uint64_t bestWeight = 0;
+			forNeighbors(fine, u, [&](uint32_t v, uint64_t weight) {
+				if (match[v] != none || fine.weight[u] + fine.weight[v] > maxWeight) return;
+				if (weight < bestWeight || (weight == bestWeight && best != u && fine.weight[v] >= fine.weight[best])) return;
+				if (acyclic && !safeContraction(fine, u, v)) return;
+				best = v;
+				bestWeight = weight;
+			});
+			match[u] = best;
+			match[best] = u;
+		}
+
+		uint32_t groups = 0;
+		fine.coarse.assign(fine.size(), none);
+		for (uint32_t u = 0; u < fine.size(); u++) {
+			if (fine.coarse[u] != none) continue;
+			fine.coarse[u] = fine.coarse[match[u]] = groups++;
+		}
+		if (groups > fine.size() - fine.size() / 20) return false;
+		coarse = contract(fine, fine.coarse, groups);
+		return !acyclic || topoOrder(coarse).size() == coarse.size();
+	}
+
+	uint64_t cut(const Level& level, const std::vector<uint32_t>& part) {
+		uint64_t total = 0;
+		for (uint32_t u = 0; u < level.size(); u++)
+			forNeighbors(level, u, [&](uint32_t v, uint64_t weight) {
+				if (u < v && part[u] != part[v]) total += weight;
+			});
+		return total;
+	}
+
+	// Grow parts 0..k-2 one after another from a random seed, always taking the
+	// vertex most strongly connected to the growing part; leftovers go to part k-1
+	std::vector<uint32_t> growPartition(const Level& level, uint32_t k, std::mt19937& rng) {
+		const uint64_t total = std::accumulate(level.weight.begin(), level.weight.end(), uint64_t{ 0 });
+		std::vector<uint32_t> order(level.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), rng);
+		std::vector<uint32_t> part(level.size(), none);
+		std::vector<uint64_t> conn(level.size(), 0);
+		uint64_t assigned = 0;
+		size_t nextSeed = 0;
+		for (uint32_t p = 0; p + 1 < k; p++) {
+			const uint64_t target = (total - assigned) / (k - p);
+			uint64_t grown = 0;
+			std::priority_queue<std::pair<uint64_t, uint32_t>> queue;
+			std::fill(conn.begin(), conn.end(), 0);
+			while (grown < target) {
+				if (queue.empty()) {
+					while (nextSeed < order.size() && part[order[nextSeed]] != none) nextSeed++;
+					if (nextSeed == order.size()) break;
+					queue.emplace(0, order[nextSeed]);
+				}
+				const auto [gain, u] = queue.top();
+				queue.pop();
+				if (part[u] != none || gain != conn[u]) continue;  // Stale entry
+				part[u] = p;
+				grown += level.weight[u];
+				forNeighbors(level, u, [&](uint32_t v, uint64_t weight) {
+					if (part[v] != none) return;
+					conn[v] += weight;
+					queue.emplace(conn[v], v);
+				});
+			}
+			assigned += grown;
+		}
+		for (uint32_t& p : part)
+			if (p == none) p = k - 1;
+		return part;
+	}
+
+	// Cut the topological order into k consecutive chunks of similar weight,
+	// so every edge goes from a part to the same or a higher numbered part
+	std::vector<uint32_t> splitTopological(const Level& level, uint32_t k) {
+		const uint64_t total = std::accumulate(level.weight.begin(), level.weight.end(), uint64_t{ 0 });
+		std::vector<uint32_t> part(level.size(), 0);
+		uint64_t running = 0;
+		for (const uint32_t u : topoOrder(level)) {
+			const uint64_t middle = running + level.weight[u] / 2;
+			part[u] = total ? static_cast<uint32_t>(std::min<uint64_t>(k - 1, middle * k / total)) : 0;
+			running += level.weight[u];
+		}
+		return part;
+	}
+
+	class Refiner {
+		const Level& level;
+		std::vector<uint32_t>& part;
+		const uint64_t maxPartWeight;
+		const bool acyclic;
+		std::vector<uint64_t> partWeight;
+		std::vector<int64_t> conn;
+
+		struct Move {
+			int64_t gain;
+			uint32_t vertex;
+			uint32_t to;
+			bool operator<(const Move& rhs) const { return gain < rhs.gain; }
+		};
+
+		// Moving keeps the parts monotone along edge direction
+		bool keepsOrder(uint32_t u, uint32_t to) const {
+			for (uint32_t i = level.inOffsets[u]; i < level.inOffsets[u + 1]; i++)
+				if (part[level.in[i]] > to) return false;
+			for (uint32_t i = level.outOffsets[u]; i < level.outOffsets[u + 1]; i++)
+				if (part[level.out[i]] < to) return false;
+			return true;
+		}
+
+		// Best move of u into a part with room, among the parts of its neighbors or, with
+		// anyPart, among all parts. Returns a move to its own part if there is none.
+		Move bestMove(uint32_t u, bool anyPart = false) {
+			const uint32_t from = part[u];
+			forNeighbors(level, u, [&](uint32_t v, uint64_t weight) { conn[part[v]] += weight; });
+			Move best{ INT64_MIN, u, from };
+			auto consider = [&](uint32_t to) {
+				if (to == from || partWeight[to] + level.weight[u] > maxPartWeight) return;
+				const int64_t gain = conn[to] - conn[from];
+				if (gain <= best.gain) return;
+				if (acyclic && !keepsOrder(u, to)) return;
+				best = { gain, u, to };
+			};
+			if (anyPart)
+				for (uint32_t to = 0; to < partWeight.size(); to++) consider(to);
+			else
+				forNeighbors(level, u, [&](uint32_t v, uint64_t) { consider(part[v]); });
+			forNeighbors(level, u, [&](uint32_t v, uint64_t) { conn[part[v]] = 0; });
+			conn[from] = 0;
+			return best;
+		}
+
+	public:
+		Refiner(const Level& level, std::vector<uint32_t>& part, uint32_t k, uint64_t maxPartWeight, bool acyclic)
+			: level(level)
+			, part(part)
+			, maxPartWeight(maxPartWeight)
+			, acyclic(acyclic)
+			, partWeight(k, 0)
+			, conn(k, 0) {
+			for (uint32_t u = 0; u < level.size(); u++) partWeight[part[u]] += level.weight[u];
+		}
+
+		// Move vertices out of parts over maxPartWeight, best gain first, until they fit or no
+		// vertex of the part fits anywhere else. The initial partition and coarse vertices can
+		// overshoot, and the gain-driven passes never move into a full part, so they cannot
+		// repair that themselves.
+		void balance() {
+			for (uint32_t from = 0; from < partWeight.size(); from++) {
+				if (partWeight[from] <= maxPartWeight) continue;
+				std::priority_queue<Move> queue;
+				for (uint32_t u = 0; u < level.size(); u++) {
+					if (part[u] != from) continue;
+					const Move move = bestMove(u, true);
+					if (move.to != from) queue.push(move);
+				}
+				while (partWeight[from] > maxPartWeight && !queue.empty()) {
+					const Move top = queue.top();
+					queue.pop();
+					const Move move = bestMove(top.vertex, true);
+					if (move.to == from) continue;
+					if (move.gain != top.gain || move.to != top.to) {
+						queue.push(move);
+						continue;
+					}
+					partWeight[from] -= level.weight[move.vertex];
+					partWeight[move.to] += level.weight[move.vertex];
+					part[move.vertex] = move.to;
+				}
+			}
+		}
+
+		// One Fiduccia-Mattheyses pass: move vertices by best gain, allowing negative
+		// gains to climb out of local minima, then roll back to the best prefix
+		int64_t pass() {
+			std::priority_queue<Move> queue;
+			std::vector<bool> locked(level.size(), false);
+			std::vector<std::pair<uint32_t, uint32_t>> moves;  // Vertex and the part it came from
+			for (uint32_t u = 0; u < level.size(); u++) {
+				const Move move = bestMove(u);
+				if (move.to != part[u]) queue.push(move);
+			}
+
+			const size_t maxUphill = std::max<size_t>(50, level.size() / 20);
+			int64_t gain = 0, bestGain = 0;
+			size_t bestMoves = 0;
+			while (!queue.empty()) {
+				const Move top = queue.top();
+				queue.pop();
+				if (locked[top.vertex]) continue;
+				const Move move = bestMove(top.vertex);
+				if (move.to == part[move.vertex]) continue;
+				if (move.gain != top.gain || move.to != top.to) {
+					queue.push(move);
+					continue;
+				}
+
+				const uint32_t u = move.vertex;
+				moves.emplace_back(u, part[u]);
+				partWeight[part[u]] -= level.weight[u];
+				partWeight[move.to] += level.weight[u];
+				part[u] = move.to;
+				locked[u] = true;
+				gain += move.gain;
+				if (gain > bestGain) {
+					bestGain = gain;
+					bestMoves = moves.size();
+				}
+				else if (moves.size() - bestMoves > maxUphill) {
+					break;
+				}
+				forNeighbors(level, u, [&](uint32_t v, uint64_t) {
+					if (locked[v]) return;
+					const Move next = bestMove(v);
+					if (next.to != part[v]) queue.push(next);
+				});
+			}
+
+			while (moves.size() > bestMoves) {
+				const auto [u, from] = moves.back();
+				moves.pop_back();
+				partWeight[part[u]] -= level.weight[u];
+				partWeight[from] += level.weight[u];
+				part[u] = from;
+			}
+			return bestGain;
+		}
+	};
+
+	void refine(const Level& level, std::vector<uint32_t>& part, uint32_t k, uint64_t maxPartWeight, bool acyclic, uint32_t passes) {
+		Refiner refiner(level, part, k, maxPartWeight, acyclic);
+		refiner.balance();
+		for (uint32_t i = 0; i < passes; i++)
+			if (refiner.pass() <= 0) break;
+	}
+}
+
+namespace graph::alg
+{
+	PartitionResult partition(const Graph& graph, const PartitionOptions& options,
+		VertexWeightFunc vertexWeight, EdgeFunc func)
+	{
+		const CsrGraph csr(graph, [&func](const Edge& edge) { return edge.weight() && func(edge); });
+		const uint32_t k = std::max(1u, options.parts);
+		std::mt19937 rng(options.seed);
+
+		// Strongly connected vertices must share a part when the parts have to stay acyclic
+		uint32_t groups = csr.vertexCount();
+		std::vector<uint32_t> group(csr.vertexCount());
+		if (options.acyclic) {
+			auto [component, sizes] = stronglyConnected(csr);
+			group = std::move(component);
+			groups = static_cast<uint32_t>(sizes.size());
+		}
+		else {
+			std::iota(group.begin(), group.end(), 0);
+		}
+
+		std::vector<uint64_t> weight(groups, 0);
+		std::vector<part::Arc> arcs;
+		arcs.reserve(csr.edgeCount());
+		for (uint32_t u = 0; u < csr.vertexCount(); u++) {
+			weight[group[u]] += vertexWeight(csr.vertex(u));
+			const auto targets = csr.outTargets(u);
+			const auto weights = csr.outWeights(u);
+			for (size_t i = 0; i < targets.size(); i++)
+				arcs.push_back({ group[u], group[targets[i]], static_cast<uint64_t>(std::abs(int64_t{ weights[i] })) });
+		}
+		const uint64_t total = std::accumulate(weight.begin(), weight.end(), uint64_t{ 0 });
+
+		std::vector<part::Level> levels;
+		levels.push_back(part::buildLevel(std::move(weight), std::move(arcs)));
+		const uint32_t coarsenTo = std::max(64u, 20 * k);
+		const uint64_t maxVertexWeight = std::max<uint64_t>(1, total * 3 / (2 * coarsenTo));
+		while (levels.back().size() > coarsenTo) {
+			part::Level next;
+			if (!part::coarsen(levels.back(), next, rng, maxVertexWeight, options.acyclic)) break;
+			levels.push_back(std::move(next));
+		}
+
+		const uint64_t maxPartWeight = static_cast<uint64_t>(std::ceil((1.0 + options.imbalance) * total / k));
+		const part::Level& coarsest = levels.back();
+		std::vector<uint32_t> part;
+		if (options.acyclic) {
+			part = part::splitTopological(coarsest, k);
+			part::refine(coarsest, part, k, maxPartWeight, true, options.refinePasses);
+		}
+		else {
+			uint64_t bestCut = UINT64_MAX;
+			for (int attempt = 0; attempt < 4; attempt++) {
+				std::vector<uint32_t> candidate = part::growPartition(coarsest, k, rng);
+				part::refine(coarsest, candidate, k, maxPartWeight, false, options.refinePasses);
+				const uint64_t candidateCut = part::cut(coarsest, candidate);
+				if (candidateCut < bestCut) {
+					bestCut = candidateCut;
+					part = std::move(candidate);
+				}
+			}
+		}
+
+		// Project back through the levels, refining on the way
+		for (size_t l = levels.size() - 1; l-- > 0;) {
+			std::vector<uint32_t> finer(levels[l].size());
+			for (uint32_t u = 0; u < levels[l].size(); u++) finer[u] = part[levels[l].coarse[u]];
+			part = std::move(finer);
+			part::refine(levels[l], part, k, maxPartWeight, options.acyclic, options.refinePasses);
+		}
+
+		PartitionResult result;
+		result.partWeights.assign(k, 0);
+		for (uint32_t u = 0; u < csr.vertexCount(); u++) {
+			const uint32_t p = part[group[u]];
+			result.part.emplace(csr.vertex(u), p);
+			result.partWeights[p] += vertexWeight(csr.vertex(u));
+			const auto targets = csr.outTargets(u);
+			const auto weights = csr.outWeights(u);
+			for (size_t i = 0; i < targets.size(); i++) {
+				if (part[group[targets[i]]] == p) continue;
+				result.cutEdges++;
+				result.cutWeight += std::abs(int64_t{ weights[i] });
+			}
+		}
+		return result;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "graphalg.hpp"
+
+#include <vector>
+namespace graph::alg
+{
+	using VertexWeightFunc = std::function<uint32_t(const Vertex&)>;
+
+	inline uint32_t unitVertexWeight(const Vertex&) { return 1; }
+
+	struct PartitionOptions {
+		uint32_t parts = 2;
+		double imbalance = 0.03;  // Allowed overweight of a part relative to the average
+		bool acyclic = false;  // Keep the quotient graph of the parts a DAG (part ids follow edge direction)
+		uint32_t refinePasses = 8;  // FM passes per level
+		uint32_t seed = 1;
+	};
+
+	struct PartitionResult {
+		VertexBindingMap<uint32_t> part;
+		std::vector<uint64_t> partWeights;
+		uint64_t cutWeight = 0;  // Sum of |Edge::weight| over edges between parts
+		uint32_t cutEdges = 0;
+	};
+
+	// Multilevel k-way partitioning: heavy-edge coarsening, greedy initial partition, FM refinement
+	PartitionResult partition(const Graph& graph, const PartitionOptions& options,
+		VertexWeightFunc vertexWeight = unitVertexWeight, EdgeFunc func = followAlwaysTrue);
+}
@@ -0,0 +1,420 @@
+#include "reader.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+using namespace graph::core;
+using graph::io::NamedVertices;
+using graph::io::ReadOptions;
+using graph::io::MappedFile;
+
+namespace parse
+{
+	struct RawEdge {
+		uint32_t from;
+		uint32_t to;
+		int weight;
+	};
+
+	struct SyntaxError {
+		const char* at;
+		const char* what;
+	};
+
+	// Name table shared by all parsing threads. Ids are shard local until finish() renumbers
+	// every name by its first appearance in the file, which makes the result independent of
+	// how the file was split.
+	class Interner {
+		static constexpr uint32_t shardBits = 6;
+		struct Entry {
+			std::string_view name;
+			const char* first;
+		};
+		struct Shard {
+			std::mutex mutex;
+			std::unordered_map<std::string_view, uint32_t> ids;
+			std::vector<Entry> entries;
+		};
+		std::array<Shard, 1u << shardBits> shards;
+		std::vector<std::vector<uint32_t>> remap;
+
+	public:
+		uint32_t intern(std::string_view name, const char* at) {
+			const uint32_t shard = static_cast<uint32_t>(std::hash<std::string_view>()(name) >> 7) & ((1u << shardBits) - 1);
+			Shard& s = shards[shard];
+			std::lock_guard<std::mutex> lock(s.mutex);
+			auto [it, inserted] = s.ids.emplace(name, static_cast<uint32_t>(s.entries.size()));
+			if (inserted) s.entries.push_back({ name, at });
+			else s.entries[it->second].first = std::min(s.entries[it->second].first, at);
+			return it->second << shardBits | shard;
+		}
+
+		// Returns the names in order of first appearance
+		std::vector<std::string_view> finish() {
+			std::vector<std::pair<const char*, uint32_t>> order;
+			for (uint32_t shard = 0; shard < shards.size(); shard++)
+				for (uint32_t i = 0; i < shards[shard].entries.size(); i++)
+					order.emplace_back(shards[shard].entries[i].first, i << shardBits | shard);
+			std::sort(order.begin(), order.end());
+			remap.resize(shards.size());
+			for (uint32_t shard = 0; shard < shards.size(); shard++) remap[shard].resize(shards[shard].entries.size());
+			std::vector<std::string_view> names;
+			names.reserve(order.size());
+			for (const auto& [first, id] : order) {
+				const uint32_t shard = id & ((1u << shardBits) - 1);
+				remap[shard][id >> shardBits] = static_cast<uint32_t>(names.size());
+				names.push_back(shards[shard].entries[id >> shardBits].name);
+			}
+			return names;
+		}
+		uint32_t final(uint32_t id) const { return remap[id & ((1u << shardBits) - 1)][id >> shardBits]; }
+	};
+
+	struct Chunk {
+		const char* begin;
+		const char* end;
+		std::vector<RawEdge> edges;
+		const char* errorAt = nullptr;
+		const char* error = nullptr;
+	};
+
+	bool blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+	int parseWeight(std::string_view text, const char* at) {
+		int weight = 0;
+		const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), weight);
+		if (ec != std::errc() || end != text.data() + text.size()) throw SyntaxError{ at, "weight must be an integer" };
+		return weight;
+	}
+
+	void parseEdgeList(Chunk& chunk, Interner& names, int defaultWeight) {
+		const char* p = chunk.begin;
+		while (p < chunk.end) {
+			const char* eol = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+			if (!eol) eol = chunk.end;
+			std::string_view tokens[3];
+			size_t count = 0;
+			while (true) {
+				while (p < eol && blank(*p)) p++;
+				if (p == eol) break;
+				if (count == 0 && (*p == '#' || *p == '%')) break;
+				if (count == 3) throw SyntaxError{ p, "too many fields" };
+				const char* start = p;
+				while (p < eol && !blank(*p)) p++;
+				tokens[count++] = std::string_view(start, p - start);
+			}
+			if (count == 1) {
+				names.intern(tokens[0], tokens[0].data());
+			}
+			else if (count > 1) {
+				const uint32_t from = names.intern(tokens[0], tokens[0].data());
+				const uint32_t to = names.intern(tokens[1], tokens[1].data());
+				const int weight = count == 3 ? parseWeight(tokens[2], tokens[2].data()) : defaultWeight;
+				chunk.edges.push_back({ from, to, weight });
+			}
+			p = eol + 1;
+		}
+	}
+
+	class DotLexer {
+	public:
+		enum Kind { End, Id, Quoted, Punct, EdgeOp };
+		struct Token {
+			Kind kind = End;
+			std::string_view text;
+			const char* at = nullptr;
+			bool is(char c) const { return kind == Punct && text[0] == c; }
+			bool name() const { return kind == Id || kind == Quoted; }
+			bool keyword(const char* word) const {
+				if (kind != Id || text.size() != std::strlen(word)) return false;
+				for (size_t i = 0; i < text.size(); i++)
+					if (std::tolower(static_cast<unsigned char>(text[i])) != word[i]) return false;
+				return true;
+			}
+		};
+
+	private:
+		const char* p;
+		const char* end;
+		Token lookahead;
+
+	public:
+		static bool idChar(char c) {
+			return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || static_cast<unsigned char>(c) >= 0x80;
+		}
+
+	private:
+
+		void skipSpaceAndComments() {
+			while (p < end) {
+				if (std::isspace(static_cast<unsigned char>(*p))) p++;
+				else if (*p == '#' || (*p == '/' && p + 1 < end && p[1] == '/')) while (p < end && *p != '\n') p++;
+				else if (*p == '/' && p + 1 < end && p[1] == '*') {
+					const char* close = std::search(p + 2, end, "*/", "*/" + 2);
+					if (close == end) throw SyntaxError{ p, "unterminated comment" };
+					p = close + 2;
+				}
+				else break;
+			}
+		}
+
+		Token scan() {
+			skipSpaceAndComments();
+			Token token;
+			token.at = p;
+			if (p == end) return token;
+			const char* start = p;
+			if (*p == '"') {
+				for (p++; p < end && *p != '"'; p++)
+					if (*p == '\\' && p + 1 < end) p++;
+				if (p == end) throw SyntaxError{ start, "unterminated string" };
+				token.kind = Quoted;
+				token.text = std::string_view(start + 1, p - start - 1);
+				p++;
+			}
+			else if (*p == '<') {
+				int depth = 0;
+				do {
+					if (*p == '<') depth++;
+					else if (*p == '>') depth--;
+					p++;
+				} while (p < end && depth);
+				if (depth) throw SyntaxError{ start, "unterminated HTML string" };
+				token.kind = Quoted;
+				token.text = std::string_view(start, p - start);
+			}
+			else if (*p == '-' && p + 1 < end && (p[1] == '>' || p[1] == '-')) {
+				p += 2;
+				token.kind = EdgeOp;
+				token.text = std::string_view(start, 2);
+			}
+			else if (std::strchr("{}[]=;,:", *p)) {
+				p++;
+				token.kind = Punct;
+				token.text = std::string_view(start, 1);
+			}
+			else if (idChar(*p) || (*p == '-' && p + 1 < end && (std::isdigit(static_cast<unsigned char>(p[1])) || p[1] == '.'))) {
+				for (p++; p < end && idChar(*p); p++) {}
+				token.kind = Id;
+				token.text = std::string_view(start, p - start);
+			}
+			else {
+				throw SyntaxError{ start, "unexpected character" };
+			}
+			return token;
+		}
+
+	public:
+		DotLexer(const char* begin, const char* end)
+			: p(begin)
+			, end(end) {
+			lookahead = scan();
+		}
+		const Token& peek() const { return lookahead; }
+		Token next() {
+			Token token = lookahead;
+			lookahead = scan();
+			return token;
+		}
+	};
+
+	// Returns the weight attribute if the list has one
+	void parseAttributes(DotLexer& lexer, int& weight) {
+		while (lexer.peek().is('[')) {
+			lexer.next();
+			while (!lexer.peek().is(']')) {
+				const auto key = lexer.next();
+				if (!key.name()) throw SyntaxError{ key.at, "expected attribute name" };
+				if (lexer.peek().is('=')) {
+					lexer.next();
+					const auto value = lexer.next();
+					if (!value.name()) throw SyntaxError{ value.at, "expected attribute value" };
+					if (key.text == "weight") weight = parseWeight(value.text, value.at);
+				}
+				if (lexer.peek().is(',') || lexer.peek().is(';')) lexer.next();
+			}
+			lexer.next();
+		}
+	}
+
+	void skipPort(DotLexer& lexer) {
+		while (lexer.peek().is(':')) {
+			lexer.next();
+			if (!lexer.next().name()) throw SyntaxError{ lexer.peek().at, "expected port name" };
+		}
+	}
+
+	void parseDot(Chunk& chunk, Interner& names, int defaultWeight) {
+		DotLexer lexer(chunk.begin, chunk.end);
+		std::vector<uint32_t> chain;
+		while (lexer.peek().kind != DotLexer::End) {
+			const auto token = lexer.next();
+			if (token.is(';') || token.is('{') || token.is('}')) continue;
+			if (token.keyword("strict")) continue;
+			if (token.keyword("graph") || token.keyword("node") || token.keyword("edge")) {
+				int unused;
+				if (lexer.peek().is('[')) {
+					parseAttributes(lexer, unused);
+					continue;
+				}
+			}
+			if (token.keyword("graph") || token.keyword("digraph") || token.keyword("subgraph")) {
+				if (lexer.peek().name()) lexer.next();
+				continue;
+			}
+			if (!token.name()) throw SyntaxError{ token.at, "expected statement" };
+			if (lexer.peek().is('=')) {  // Graph attribute
+				lexer.next();
+				if (!lexer.next().name()) throw SyntaxError{ token.at, "expected attribute value" };
+				continue;
+			}
+
+			chain.assign(1, names.intern(token.text, token.at));
+			skipPort(lexer);
+			while (lexer.peek().kind == DotLexer::EdgeOp) {
+				lexer.next();
+				const auto to = lexer.next();
+				if (!to.name() || to.keyword("subgraph")) throw SyntaxError{ to.at, "expected node name after edge operator" };
+				chain.push_back(names.intern(to.text, to.at));
+				skipPort(lexer);
+			}
+			int weight = defaultWeight;
+			parseAttributes(lexer, weight);
+			for (size_t i = 1; i < chain.size(); i++) chunk.edges.push_back({ chain[i - 1], chain[i], weight });
+		}
+	}
+
+	// Chunk ends right after a newline at or past each target
+	std::vector<const char*> lineSplits(const char* begin, const char* end, size_t parts) {
+		std::vector<const char*> splits{ begin };
+		for (size_t i = 1; i < parts; i++) {
+			const char* target = std::max(splits.back(), begin + (end - begin) * i / parts);
+			const char* eol = static_cast<const char*>(std::memchr(target, '\n', end - target));
+			splits.push_back(eol ? eol + 1 : end);
+		}
+		splits.push_back(end);
+		return splits;
+	}
+
+	// Whether the last word before p is one of the keywords that take a name, as a whole word
+	bool endsWithGraphKeyword(const char* begin, const char* p) {
+		while (p > begin && std::isspace(static_cast<unsigned char>(p[-1]))) p--;
+		const char* word = p;
+		while (word > begin && DotLexer::idChar(word[-1])) word--;
+		const std::string_view text(word, p - word);
+		for (const char* keyword : { "graph", "digraph", "subgraph" })
+			if (text.size() == std::strlen(keyword) && std::equal(text.begin(), text.end(), keyword, [](char a, char b) {
+				return std::tolower(static_cast<unsigned char>(a)) == b;
+			}))
+				return true;
+		return false;
+	}
+
+	// DOT statements may span lines, so only split at a newline outside strings, comments and
+	// attribute lists where neither the line before nor the line after continues an edge or
+	// attribute, and not between a graph keyword and its name
+	std::vector<const char*> dotSplits(const char* begin, const char* end, size_t parts) {
+		std::vector<const char*> splits{ begin };
+		char last = 0;
+		int depth = 0;
+		for (const char* p = begin; p < end && splits.size() < parts; p++) {
+			const char c = *p;
+			if (c == '"') {
+				for (p++; p < end && *p != '"'; p++)
+					if (*p == '\\' && p + 1 < end) p++;
+				last = '"';
+			}
+			else if (c == '/' && p + 1 < end && p[1] == '*') {
+				const char* close = std::search(p + 2, end, "*/", "*/" + 2);
+				p = close == end ? end : close + 1;
+			}
+			else if ((c == '/' && p + 1 < end && p[1] == '/') || c == '#') {
+				while (p + 1 < end && p[1] != '\n') p++;
+			}
+			else if (c == '[') depth++;
+			else if (c == ']') depth--;
+			else if (c == '\n') {
+				if (depth || last == '-' || last == '>' || last == '=' || p + 1 - begin < static_cast<ptrdiff_t>((end - begin) * splits.size() / parts))
+					continue;
+				if (endsWithGraphKeyword(begin, p)) continue;
+				const char* q = p + 1;
+				while (q < end && std::isspace(static_cast<unsigned char>(*q))) q++;
+				if (q < end && (*q == '[' || *q == '=' || *q == ':' || (*q == '-' && q + 1 < end && (q[1] == '>' || q[1] == '-')))) continue;
+				splits.push_back(p + 1);
+			}
+			else if (!std::isspace(static_cast<unsigned char>(c))) last = c;
+		}
+		splits.push_back(end);
+		return splits;
+	}
+
+	template <typename F>
+	NamedVertices read(const std::string& path, Graph& graph, const ReadOptions& options, bool dot, F&& parseChunk) {
+		const MappedFile file(path);
+		const char* begin = file.data();
+		const char* end = begin + file.size();
+		const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+		const size_t parts = file.size() < (1 << 20) ? 1 : threads;
+		const auto splits = dot ? dotSplits(begin, end, parts) : lineSplits(begin, end, parts);
+
+		Interner names;
+		std::vector<Chunk> chunks(splits.size() - 1);
+		auto work = [&](size_t i) {
+			chunks[i].begin = splits[i];
+			chunks[i].end = splits[i + 1];
+			try {
+				parseChunk(chunks[i], names, options.weight);
+			}
+			catch (const SyntaxError& error) {
+				chunks[i].errorAt = error.at;
+				chunks[i].error = error.what;
+			}
+		};
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < chunks.size(); i++) workers.emplace_back(work, i);
+		work(0);
+		for (auto& worker : workers) worker.join();
+
+		for (const Chunk& chunk : chunks) {
+			if (!chunk.error) continue;
+			const size_t line = std::count(begin, chunk.errorAt, '\n') + 1;
+			throw std::runtime_error("graph::io: " + path + ":" + std::to_string(line) + ": " + chunk.error);
+		}
+
+		NamedVertices result;
+		const std::vector<std::string_view> order = names.finish();
+		result.names.assign(order.begin(), order.end());
+		for (Vertex& vertex : graph.addVertices(order.size())) result.vertices.push_back(&vertex);
+		size_t edges = 0;
+		for (const Chunk& chunk : chunks) edges += chunk.edges.size();
+		std::vector<EdgeSpec> specs;
+		specs.reserve(edges);
+		for (const Chunk& chunk : chunks)
+			for (const RawEdge& edge : chunk.edges)
+				specs.push_back({ *result.vertices[names.final(edge.from)], *result.vertices[names.final(edge.to)], edge.weight });
+		graph.addEdges(specs, threads);
+		return result;
+	}
+}
+
+namespace graph::io
+{
+	NamedVertices readEdgeList(const std::string& path, Graph& graph, const ReadOptions& options)
+	{
+		return parse::read(path, graph, options, false, parse::parseEdgeList);
+	}
+
+	NamedVertices readDot(const std::string& path, Graph& graph, const ReadOptions& options)
+	{
+		return parse::read(path, graph, options, true, parse::parseDot);
+	}
+}
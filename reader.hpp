@@ -0,0 +1,33 @@
+#pragma once
+#include "graph.hpp"
+
+#include <string>
+#include <vector>
+namespace graph::io
+{
+	using namespace graph::core;
+
+	struct ReadOptions {
+		unsigned threads = 0;  // 0 uses every hardware thread
+		int weight = 1;  // Weight of edges that do not give one
+	};
+
+	// Vertices added by a reader, in order of first appearance in the file
+	struct NamedVertices {
+		std::vector<Vertex*> vertices;
+		std::vector<std::string> names;
+	};
+
+	// The file is mapped and cut into chunks that are parsed concurrently, names are interned
+	// in a sharded hash table and the graph is then built with addVertices()/addEdges().
+	// Both throw std::runtime_error with the line number on a syntax error.
+
+	// One edge per line: "from to [weight]"; a line with a single name declares a vertex,
+	// lines starting with '#' or '%' are comments
+	NamedVertices readEdgeList(const std::string& path, Graph& graph, const ReadOptions& options = {});
+
+	// Graphviz subset: node and edge statements (including chains a -> b -> c) with an optional
+	// weight attribute; graph/node/edge defaults, graph attributes and subgraph braces are skipped.
+	// Escapes in quoted names are kept as written.
+	NamedVertices readDot(const std::string& path, Graph& graph, const ReadOptions& options = {});
+}
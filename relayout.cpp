@@ -0,0 +1,115 @@
+#include "relayout.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace graph::alg
+{
+	namespace
+	{
+		std::vector<uint32_t> breadthFirst(const CsrGraph& csr)
+		{
+			std::vector<uint32_t> order;
+			order.reserve(csr.vertexCount());
+			std::vector<bool> visited(csr.vertexCount(), false);
+			auto bfs = [&](uint32_t root) {
+				visited[root] = true;
+				order.push_back(root);
+				for (size_t head = order.size() - 1; head < order.size(); head++)
+					for (const uint32_t to : csr.outTargets(order[head]))
+						if (!visited[to]) {
+							visited[to] = true;
+							order.push_back(to);
+						}
+			};
+			for (uint32_t id = 0; id < csr.vertexCount(); id++)
+				if (!visited[id] && csr.inSources(id).empty()) bfs(id);
+			for (uint32_t id = 0; id < csr.vertexCount(); id++)
+				if (!visited[id]) bfs(id);
+			return order;
+		}
+
+		std::vector<uint32_t> reverseCuthillMcKee(const CsrGraph& csr)
+		{
+			auto degree = [&csr](uint32_t id) { return csr.outTargets(id).size() + csr.inSources(id).size(); };
+			std::vector<uint32_t> byDegree(csr.vertexCount());
+			for (uint32_t id = 0; id < csr.vertexCount(); id++) byDegree[id] = id;
+			std::stable_sort(byDegree.begin(), byDegree.end(), [&degree](uint32_t a, uint32_t b) { return degree(a) < degree(b); });
+
+			// Each component starts at its vertex of least degree, neighbors join by increasing degree
+			std::vector<uint32_t> order;
+			order.reserve(csr.vertexCount());
+			std::vector<bool> visited(csr.vertexCount(), false);
+			std::vector<uint32_t> neighbors;
+			for (const uint32_t root : byDegree) {
+				if (visited[root]) continue;
+				visited[root] = true;
+				order.push_back(root);
+				for (size_t head = order.size() - 1; head < order.size(); head++) {
+					neighbors.clear();
+					for (const uint32_t to : csr.outTargets(order[head]))
+						if (!visited[to]) {
+							visited[to] = true;
+							neighbors.push_back(to);
+						}
+					for (const uint32_t from : csr.inSources(order[head]))
+						if (!visited[from]) {
+							visited[from] = true;
+							neighbors.push_back(from);
+						}
+					std::stable_sort(neighbors.begin(), neighbors.end(), [&degree](uint32_t a, uint32_t b) { return degree(a) < degree(b); });
+					order.insert(order.end(), neighbors.begin(), neighbors.end());
+				}
+			}
+			std::reverse(order.begin(), order.end());
+			return order;
+		}
+
+		std::vector<uint32_t> topological(const CsrGraph& csr)
+		{
+			std::vector<uint32_t> pending(csr.vertexCount());
+			std::vector<uint32_t> order;
+			order.reserve(csr.vertexCount());
+			for (uint32_t id = 0; id < csr.vertexCount(); id++)
+				if (!(pending[id] = static_cast<uint32_t>(csr.inSources(id).size()))) order.push_back(id);
+			for (size_t head = 0; head < order.size(); head++)
+				for (const uint32_t to : csr.outTargets(order[head]))
+					if (!--pending[to]) order.push_back(to);
+			if (order.size() != csr.vertexCount()) throw std::invalid_argument("graph::alg::layoutOrder: graph has a cycle");
+			return order;
+		}
+
+		std::vector<uint32_t> sccGrouped(const CsrGraph& csr)
+		{
+			// Components come in reverse topological order, so count down
+			auto [component, sizes] = stronglyConnected(csr);
+			if (sizes.empty()) return {};
+			std::vector<uint32_t> next(sizes.size(), 0);
+			for (size_t c = sizes.size() - 1; c-- > 0;) next[c] = next[c + 1] + sizes[c + 1];
+			std::vector<uint32_t> order(csr.vertexCount());
+			for (uint32_t id = 0; id < csr.vertexCount(); id++) order[next[component[id]]++] = id;
+			return order;
+		}
+	}
+
+	std::vector<uint32_t> layoutOrder(const CsrGraph& csr, Layout layout)
+	{
+		switch (layout) {
+		case Layout::Bfs: return breadthFirst(csr);
+		case Layout::ReverseCuthillMcKee: return reverseCuthillMcKee(csr);
+		case Layout::Topological: return topological(csr);
+		case Layout::SccGrouped: return sccGrouped(csr);
+		}
+		throw std::invalid_argument("graph::alg::layoutOrder: unknown layout");
+	}
+
+	Relayout relayout(Graph& graph, Layout layout, EdgeFunc func)
+	{
+		VertexBindingVec order;
+		{
+			const CsrGraph csr(graph, std::move(func));
+			for (const uint32_t id : layoutOrder(csr, layout)) order.push_back(csr.vertex(id));
+		}
+		return graph.relayout(order);
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "csr.hpp"
+
+#include <vector>
+namespace graph::alg
+{
+	enum class Layout {
+		Bfs,  // Breadth first along out edges, roots without predecessors first
+		ReverseCuthillMcKee,  // Bandwidth reducing, edges taken as undirected
+		Topological,  // Sources first; the graph must be acyclic
+		SccGrouped  // Strongly connected components kept together, in topological order
+	};
+
+	// Permutation of the CsrGraph ids, position i holds the id to put at i. Ties keep id order.
+	// Throws std::invalid_argument for Layout::Topological on a cyclic graph.
+	std::vector<uint32_t> layoutOrder(const CsrGraph& csr, Layout layout);
+
+	// Graph::relayout() by an ordering of the followed layer 0 edges; all edges are kept
+	Relayout relayout(Graph& graph, Layout layout, EdgeFunc func = followAlwaysTrue);
+}
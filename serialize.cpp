@@ -0,0 +1,299 @@
+#include "serialize.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace serial
+{
+	using graph::io::ColumnKind;
+	using graph::io::ColumnType;
+
+	constexpr char magic[8] = { 'L', 'I', 'B', 'G', 'R', 'A', 'P', 'H' };
+	constexpr uint32_t byteOrderMark = 0x01020304;
+	constexpr uint64_t alignment = 64;
+	constexpr size_t nameLength = 48;
+
+	enum Section { OutOffsets, OutTargets, OutWeights, InOffsets, InSources, InWeights, Sections };
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint64_t vertexCount;
+		uint64_t edgeCount;
+		uint64_t sections[Sections];  // File offsets
+		uint64_t columnCount;
+		uint64_t columnTable;
+		uint64_t fileSize;
+	};
+
+	struct ColumnEntry {
+		char name[nameLength];
+		uint32_t kind;
+		uint32_t type;
+		uint64_t offset;
+		uint64_t count;
+	};
+
+	uint64_t align(uint64_t offset) { return (offset + alignment - 1) / alignment * alignment; }
+
+	size_t typeSize(ColumnType type) {
+		switch (type) {
+		case ColumnType::UInt32:
+		case ColumnType::Int32: return 4;
+		case ColumnType::UInt64:
+		case ColumnType::Int64:
+		case ColumnType::Float64: return 8;
+		}
+		return 0;
+	}
+
+	[[noreturn]] void fail(const std::string& path, const char* what) {
+		throw std::runtime_error("graph::io: " + path + ": " + what);
+	}
+
+	// Where everything goes, emit() then hands out the pieces front to back
+	struct Layout {
+		const std::vector<graph::io::Column>& columns;
+		Header header{};
+		std::vector<ColumnEntry> table;
+		const void* data[Sections];
+		uint64_t bytes[Sections];
+		uint32_t emptyOffsets = 0;  // Offsets of a graph without vertices
+
+		Layout(const graph::alg::CsrGraph& csr, const std::vector<graph::io::Column>& columns)
+			: columns(columns)
+			, table(columns.size()) {
+			const graph::alg::CsrGraph::Arrays& arrays = csr.arrays();
+			const uint64_t rows = (uint64_t{ arrays.vertexCount } + 1) * sizeof(uint32_t);
+			const uint64_t edges = uint64_t{ arrays.edgeCount } * sizeof(uint32_t);
+			const void* sections[Sections] = { arrays.outOffsets, arrays.outTargets, arrays.outWeights,
+				arrays.inOffsets, arrays.inSources, arrays.inWeights };
+			const uint64_t sizes[Sections] = { rows, edges, edges, rows, edges, edges };
+			std::copy(sections, sections + Sections, data);
+			std::copy(sizes, sizes + Sections, bytes);
+			if (!arrays.vertexCount) data[OutOffsets] = data[InOffsets] = &emptyOffsets;
+
+			std::memcpy(header.magic, magic, sizeof(magic));
+			header.version = graph::io::formatVersion;
+			header.byteOrder = byteOrderMark;
+			header.vertexCount = arrays.vertexCount;
+			header.edgeCount = arrays.edgeCount;
+			uint64_t offset = align(sizeof(header));
+			for (int s = 0; s < Sections; s++) {
+				header.sections[s] = offset;
+				offset = align(offset + bytes[s]);
+			}
+			header.columnCount = columns.size();
+			header.columnTable = offset;
+			offset = align(offset + columns.size() * sizeof(ColumnEntry));
+			for (size_t i = 0; i < columns.size(); i++) {
+				const graph::io::Column& column = columns[i];
+				if (column.name.size() >= nameLength) throw std::invalid_argument("graph::io::writeGraph: column name too long: " + column.name);
+				std::memcpy(table[i].name, column.name.data(), column.name.size());
+				table[i].kind = static_cast<uint32_t>(column.kind);
+				table[i].type = static_cast<uint32_t>(column.type);
+				table[i].count = column.kind == ColumnKind::Vertex ? arrays.vertexCount : arrays.edgeCount;
+				table[i].offset = offset;
+				offset = align(offset + table[i].count * typeSize(column.type));
+			}
+			header.fileSize = offset;
+		}
+
+		// write(offset, data, bytes), the last call is write(fileSize, nullptr, 0)
+		template <typename F>
+		void emit(F&& write) const {
+			write(0, &header, sizeof(header));
+			for (int s = 0; s < Sections; s++) write(header.sections[s], data[s], bytes[s]);
+			write(header.columnTable, table.data(), table.size() * sizeof(ColumnEntry));
+			for (size_t i = 0; i < columns.size(); i++)
+				write(table[i].offset, columns[i].data, table[i].count * typeSize(columns[i].type));
+			write(header.fileSize, nullptr, 0);
+		}
+	};
+}
+
+namespace graph::io
+{
+	struct MappedGraph::Mapping {
+		MappedFile file;
+		const char* base;
+		size_t size;
+		CsrGraph::Arrays arrays;
+		const serial::ColumnEntry* columns = nullptr;
+		uint64_t columnCount = 0;
+
+		Mapping(const std::string& path, bool shared)
+			: file(shared ? MappedFile::shared(path) : MappedFile(path))
+			, base(file.data())
+			, size(file.size()) {
+			if (size < sizeof(serial::Header)) serial::fail(path, "not a graph file");
+			validate(path);
+		}
+
+		// The mapping starts on a page, so an aligned offset gives aligned elements
+		bool fits(uint64_t offset, uint64_t bytes, uint64_t align) const {
+			return offset % align == 0 && offset <= size && bytes <= size - offset;
+		}
+
+		// Offsets run from 0 to edgeCount without going back, ids are below vertexCount
+		bool validRows(const uint32_t* offsets, const uint32_t* ids) const {
+			if (offsets[0] != 0 || offsets[arrays.vertexCount] != arrays.edgeCount) return false;
+			for (uint32_t v = 0; v < arrays.vertexCount; v++)
+				if (offsets[v] > offsets[v + 1]) return false;
+			for (uint32_t e = 0; e < arrays.edgeCount; e++)
+				if (ids[e] >= arrays.vertexCount) return false;
+			return true;
+		}
+
+		// The in rows hold the out edges reversed, each row with its sources in the order the
+		// writer scatters them. Both row sets are valid already, so no row can overflow.
+		bool sameEdges() const {
+			std::vector<uint32_t> fill(arrays.inOffsets, arrays.inOffsets + arrays.vertexCount);
+			for (uint32_t from = 0; from < arrays.vertexCount; from++)
+				for (uint32_t e = arrays.outOffsets[from]; e < arrays.outOffsets[from + 1]; e++) {
+					const uint32_t to = arrays.outTargets[e];
+					if (fill[to] == arrays.inOffsets[to + 1] || arrays.inSources[fill[to]++] != from) return false;
+				}
+			return true;
+		}
+
+		// Every offset and id is checked, so algorithms on a damaged or crafted file cannot read
+		// past the mapping or misaligned, and the in rows must mirror the out rows. Weights and
+		// column values are taken as they are.
+		void validate(const std::string& path) {
+			const auto& header = *reinterpret_cast<const serial::Header*>(base);
+			if (std::memcmp(header.magic, serial::magic, sizeof(serial::magic)) != 0) serial::fail(path, "not a graph file");
+			if (header.byteOrder != serial::byteOrderMark) serial::fail(path, "written with a different byte order");
+			if (header.version != formatVersion) serial::fail(path, "unsupported format version");
+			if (header.fileSize != size) serial::fail(path, "truncated");
+			if (header.vertexCount >= UINT32_MAX || header.edgeCount > UINT32_MAX) serial::fail(path, "too large");
+
+			const uint64_t rows = (header.vertexCount + 1) * sizeof(uint32_t);
+			const uint64_t edges = header.edgeCount * sizeof(uint32_t);
+			const uint64_t bytes[serial::Sections] = { rows, edges, edges, rows, edges, edges };
+			for (int s = 0; s < serial::Sections; s++)
+				if (!fits(header.sections[s], bytes[s], sizeof(uint32_t))) serial::fail(path, "corrupt section table");
+			auto at = [this, &header](int s) { return base + header.sections[s]; };
+			arrays.vertexCount = static_cast<uint32_t>(header.vertexCount);
+			arrays.edgeCount = static_cast<uint32_t>(header.edgeCount);
+			arrays.outOffsets = reinterpret_cast<const uint32_t*>(at(serial::OutOffsets));
+			arrays.outTargets = reinterpret_cast<const uint32_t*>(at(serial::OutTargets));
+			arrays.outWeights = reinterpret_cast<const int32_t*>(at(serial::OutWeights));
+			arrays.inOffsets = reinterpret_cast<const uint32_t*>(at(serial::InOffsets));
+			arrays.inSources = reinterpret_cast<const uint32_t*>(at(serial::InSources));
+			arrays.inWeights = reinterpret_cast<const int32_t*>(at(serial::InWeights));
+			if (!validRows(arrays.outOffsets, arrays.outTargets) || !validRows(arrays.inOffsets, arrays.inSources)) serial::fail(path, "corrupt rows");
+			if (!sameEdges()) serial::fail(path, "in and out rows differ");
+
+			if (header.columnCount > size / sizeof(serial::ColumnEntry) || !fits(header.columnTable, header.columnCount * sizeof(serial::ColumnEntry), alignof(serial::ColumnEntry)))
+				serial::fail(path, "corrupt column table");
+			columns = reinterpret_cast<const serial::ColumnEntry*>(base + header.columnTable);
+			columnCount = header.columnCount;
+			for (uint64_t i = 0; i < columnCount; i++) {
+				const serial::ColumnEntry& column = columns[i];
+				const size_t element = serial::typeSize(static_cast<ColumnType>(column.type));
+				const uint64_t expect = column.kind == static_cast<uint32_t>(ColumnKind::Vertex) ? header.vertexCount : header.edgeCount;
+				if (!element || column.count != expect || !fits(column.offset, column.count * element, element) || column.name[serial::nameLength - 1])
+					serial::fail(path, "corrupt column");
+			}
+		}
+	};
+
+	void writeGraph(const std::string& path, const CsrGraph& csr, const std::vector<Column>& columns)
+	{
+		const serial::Layout layout(csr, columns);
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out) serial::fail(path, "cannot create");
+		uint64_t position = 0;
+		layout.emit([&](uint64_t at, const void* p, uint64_t n) {
+			static const char zeros[serial::alignment] = {};
+			while (position < at) {
+				const uint64_t pad = std::min<uint64_t>(at - position, sizeof(zeros));
+				out.write(zeros, pad);
+				position += pad;
+			}
+			out.write(static_cast<const char*>(p), n);
+			position += n;
+		});
+		if (!out.flush()) serial::fail(path, "write failed");
+	}
+
+	void publishGraph(const std::string& name, const CsrGraph& csr, const std::vector<Column>& columns)
+	{
+		const serial::Layout layout(csr, columns);
+		::shm_unlink(name.c_str());
+		const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+		if (fd < 0) serial::fail(name, "cannot create");
+		void* p = MAP_FAILED;
+		if (::ftruncate(fd, layout.header.fileSize) == 0)
+			p = ::mmap(nullptr, layout.header.fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED) {
+			::shm_unlink(name.c_str());
+			serial::fail(name, "cannot map");
+		}
+		char* base = static_cast<char*>(p);
+		layout.emit([base](uint64_t at, const void* data, uint64_t n) {
+			if (at && n) std::memcpy(base + at, data, n);
+		});
+		// The header goes in last, readers attaching early see an invalid segment instead of a partial graph
+		std::atomic_thread_fence(std::memory_order_release);
+		std::memcpy(base, &layout.header, sizeof(layout.header));
+		::munmap(p, layout.header.fileSize);
+	}
+
+	void unpublishGraph(const std::string& name)
+	{
+		::shm_unlink(name.c_str());
+	}
+
+	void writeGraph(const std::string& path, const Graph& graph, EdgeFunc func)
+	{
+		writeGraph(path, CsrGraph(graph, func));
+	}
+
+	MappedGraph::MappedGraph(const std::string& path)
+		: MappedGraph(std::make_shared<const Mapping>(path, false))
+	{
+	}
+
+	MappedGraph::MappedGraph(std::shared_ptr<const Mapping> mapping)
+		: m_mapping(std::move(mapping))
+		, m_graph(m_mapping->arrays, m_mapping)
+	{
+	}
+
+	MappedGraph MappedGraph::attach(const std::string& name)
+	{
+		return MappedGraph(std::make_shared<const Mapping>(name, true));
+	}
+
+	const void* MappedGraph::find(const std::string& name, ColumnKind kind, ColumnType type, uint32_t& size) const
+	{
+		for (uint64_t i = 0; i < m_mapping->columnCount; i++) {
+			const serial::ColumnEntry& column = m_mapping->columns[i];
+			if (name == column.name && column.kind == static_cast<uint32_t>(kind) && column.type == static_cast<uint32_t>(type)) {
+				size = static_cast<uint32_t>(column.count);
+				return m_mapping->base + column.offset;
+			}
+		}
+		throw std::out_of_range("graph::io::MappedGraph: no column " + name);
+	}
+
+	bool MappedGraph::hasColumn(const std::string& name) const
+	{
+		for (uint64_t i = 0; i < m_mapping->columnCount; i++)
+			if (name == m_mapping->columns[i].name) return true;
+		return false;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "csr.hpp"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+namespace graph::io
+{
+	using namespace graph::core;
+	using graph::alg::CsrGraph;
+
+	// Binary graph file, native byte order:
+	//     Header
+	//     out offsets, out targets, out weights, in offsets, in sources, in weights
+	//     column table, column data
+	// Every section starts on a 64 byte boundary so it can be used in place from a mapping.
+	constexpr uint32_t formatVersion = 1;
+
+	enum class ColumnKind : uint32_t { Vertex, Edge };
+	enum class ColumnType : uint32_t { UInt32, Int32, UInt64, Int64, Float64 };
+
+	// A property column to store alongside the graph, one value per CsrGraph vertex id or out edge position
+	struct Column {
+		std::string name;  // At most 47 characters
+		ColumnKind kind;
+		ColumnType type;
+		const void* data;
+	};
+
+	// Throws std::runtime_error on I/O failure
+	void writeGraph(const std::string& path, const CsrGraph& csr, const std::vector<Column>& columns = {});
+	void writeGraph(const std::string& path, const Graph& graph, EdgeFunc func = graph::alg::followAlwaysTrue);
+
+	// Publish a snapshot as a POSIX shared memory object laid out like a graph file, name as for
+	// shm_open(), e.g. "/graph". Publishing again replaces the object; processes that attached
+	// earlier keep the old snapshot. The object lives until unpublishGraph() or reboot.
+	void publishGraph(const std::string& name, const CsrGraph& csr, const std::vector<Column>& columns = {});
+	void unpublishGraph(const std::string& name);
+
+	// Read only view of a graph file mapped into memory. Opening checks the header and makes one
+	// read only pass over the offsets and ids, nothing is copied.
+	// graph() stays usable for as long as this object or the CsrGraph itself (which shares the mapping) lives.
+	class MappedGraph {
+		struct Mapping;
+		std::shared_ptr<const Mapping> m_mapping;
+		CsrGraph m_graph;
+
+		explicit MappedGraph(std::shared_ptr<const Mapping> mapping);
+		const void* find(const std::string& name, ColumnKind kind, ColumnType type, uint32_t& size) const;
+
+	public:
+		explicit MappedGraph(const std::string& path);  // Throws std::runtime_error if the file is not a valid graph file
+		static MappedGraph attach(const std::string& name);  // Read only view of a published snapshot, throws like the constructor
+		const CsrGraph& graph() const { return m_graph; }
+		bool hasColumn(const std::string& name) const;
+
+		// Throws std::out_of_range if there is no column with this name, kind and type
+		template <typename T>
+		CsrGraph::Range<T> column(const std::string& name, ColumnKind kind) const {
+			uint32_t size;
+			const T* data = static_cast<const T*>(find(name, kind, typeOf<T>(), size));
+			return { data, data + size };
+		}
+
+	private:
+		template <typename T>
+		static constexpr ColumnType typeOf() {
+			if constexpr (std::is_same_v<T, uint32_t>) return ColumnType::UInt32;
+			else if constexpr (std::is_same_v<T, int32_t>) return ColumnType::Int32;
+			else if constexpr (std::is_same_v<T, uint64_t>) return ColumnType::UInt64;
+			else if constexpr (std::is_same_v<T, int64_t>) return ColumnType::Int64;
+			else {
+				static_assert(std::is_same_v<T, double>, "unsupported column type");
+				return ColumnType::Float64;
+			}
+		}
+	};
+}
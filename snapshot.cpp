@@ -0,0 +1,25 @@
+#include "snapshot.hpp"
+
+#include <atomic>
+
+namespace graph::alg
+{
+	SnapshotPublisher::SnapshotPublisher(const Graph& graph, EdgeFunc func)
+		: m_graph(graph)
+		, m_func(std::move(func))
+	{
+		publish();
+	}
+
+	uint64_t SnapshotPublisher::publish()
+	{
+		auto snapshot = std::make_shared<const Snapshot>(Snapshot{ ++m_version, CsrGraph(m_graph, m_func) });
+		std::atomic_store_explicit(&m_current, std::shared_ptr<const Snapshot>(std::move(snapshot)), std::memory_order_release);
+		return m_version;
+	}
+
+	std::shared_ptr<const Snapshot> SnapshotPublisher::current() const
+	{
+		return std::atomic_load_explicit(&m_current, std::memory_order_acquire);
+	}
+}
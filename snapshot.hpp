@@ -0,0 +1,30 @@
+#pragma once
+#include "csr.hpp"
+
+#include <cstdint>
+#include <memory>
+namespace graph::alg
+{
+	// Immutable version of a Graph for readers on other threads
+	struct Snapshot {
+		uint64_t version;
+		CsrGraph graph;
+	};
+
+	// Lets analyses run on other threads while one writer keeps editing the Graph. The writer
+	// calls publish() between edits, readers take current() and work on that frozen CsrGraph;
+	// a snapshot is freed when the last reader holding it lets go. Readers should only use the
+	// ids of a snapshot: vertex() references stay valid while the Graph lives, but their edge
+	// lists belong to the writer.
+	class SnapshotPublisher {
+		const Graph& m_graph;
+		EdgeFunc m_func;
+		uint64_t m_version = 0;
+		std::shared_ptr<const Snapshot> m_current;
+
+	public:
+		explicit SnapshotPublisher(const Graph& graph, EdgeFunc func = followAlwaysTrue);
+		uint64_t publish();  // Writer thread only, returns the new version
+		std::shared_ptr<const Snapshot> current() const;  // Any thread
+	};
+}
@@ -1,9 +1,36 @@
 #include "graph.hpp"
 #include "graphalg.hpp"
+#include "partition.hpp"
+#include "executor.hpp"
+#include "incremental.hpp"
+#include "dataflow.hpp"
+#include "generators.hpp"
+#include "serialize.hpp"
+#include "reader.hpp"
+#include "writer.hpp"
+#include "builder.hpp"
+#include "snapshot.hpp"
+#include "datagraph.hpp"
+#include "attributes.hpp"
+#include "edgemask.hpp"
+#include "compact.hpp"
+#include "relayout.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <iostream>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
@@ -24,6 +51,13 @@ public:
 	operator Graph& () { return graph; }
 };
 
+// Temp file path of its own per call and process, so concurrent test runs do not collide
+std::string tempPath(const char* extension) {
+	static std::atomic<unsigned> counter{ 0 };
+	const std::string name = "libgraph_test_" + std::to_string(::getpid()) + "_" + std::to_string(counter++) + extension;
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
 TEST_CASE("test strongly connected component", "Graph") {
 	StrGraph graph;
 	Vertex& i = graph.newVertex("*INPUTS*");
@@ -89,4 +123,1148 @@ TEST_CASE("test rank algorithm", "Graph") {
 	REQUIRE(loopsMap[v4][1] == v5);
 	REQUIRE(loopsMap[v4][2] == v4);
 	REQUIRE(loopsMap.count(v6) == 0); // No loop start from v6
-}
\ No newline at end of file
+}
+
+TEST_CASE("test weakly connected component", "Graph") {
+	Graph graph;
+	Vertex& v1 = graph.newVertex();
+	Vertex& v2 = graph.newVertex();
+	Vertex& v3 = graph.newVertex();
+	Vertex& v4 = graph.newVertex();
+	Vertex& v5 = graph.newVertex();
+	Vertex& v6 = graph.newVertex();
+	graph.newEdge(v2, v1, 1);
+	graph.newEdge(v3, v2, 1);
+	graph.newEdge(v4, v5, 1);
+	graph.newEdge(v5, v6, 0); // Zero weight edges are not followed
+	auto [component, sizes] = graph::alg::weaklyConnected(graph);
+	REQUIRE(sizes.size() == 3);
+	REQUIRE(component[v1] == 0);
+	REQUIRE(component[v2] == 0);
+	REQUIRE(component[v3] == 0);
+	REQUIRE(component[v4] == 1);
+	REQUIRE(component[v5] == 1);
+	REQUIRE(component[v6] == 2);
+	REQUIRE(sizes[0] == 3);
+	REQUIRE(sizes[1] == 2);
+	REQUIRE(sizes[2] == 1);
+}
+
+TEST_CASE("test k-way partition", "Graph") {
+	Graph graph;
+	std::vector<Vertex*> left, right;
+	for (int i = 0; i < 8; i++) left.push_back(&graph.newVertex());
+	for (int i = 0; i < 8; i++) right.push_back(&graph.newVertex());
+	for (int i = 0; i < 8; i++)
+		for (int j = 0; j < 8; j++)
+			if (i != j) {
+				graph.newEdge(*left[i], *left[j], 5);
+				graph.newEdge(*right[i], *right[j], 5);
+			}
+	graph.newEdge(*left[0], *right[0], 1);
+
+	graph::alg::PartitionOptions options;
+	options.parts = 2;
+	auto result = graph::alg::partition(graph, options);
+	REQUIRE(result.cutEdges == 1);
+	REQUIRE(result.cutWeight == 1);
+	REQUIRE(result.partWeights[0] == 8);
+	REQUIRE(result.partWeights[1] == 8);
+	for (int i = 1; i < 8; i++) {
+		REQUIRE(result.part[*left[i]] == result.part[*left[0]]);
+		REQUIRE(result.part[*right[i]] == result.part[*right[0]]);
+	}
+	REQUIRE(result.part[*left[0]] != result.part[*right[0]]);
+
+	// Heavy vertices make the initial parts overshoot, balancing brings them back in bounds
+	Graph skewed;
+	graph::gen::powerLaw(skewed, 2000, 3, { 23 });
+	options.parts = 3;
+	options.seed = 23;
+	const auto heavy = [](const Vertex& vertex) { return vertex.id() % 13 == 0 ? 40u : 1u; };
+	result = graph::alg::partition(skewed, options, heavy);
+	const uint64_t total = std::accumulate(result.partWeights.begin(), result.partWeights.end(), uint64_t{ 0 });
+	for (const uint64_t weight : result.partWeights)
+		REQUIRE(weight <= static_cast<uint64_t>(std::ceil((1.0 + options.imbalance) * total / options.parts)));
+}
+
+TEST_CASE("test acyclic partition", "Graph") {
+	Graph graph;
+	std::vector<Vertex*> chain;
+	for (int i = 0; i < 12; i++) chain.push_back(&graph.newVertex());
+	for (int i = 0; i + 1 < 12; i++) graph.newEdge(*chain[i], *chain[i + 1], 1);
+	graph.newEdge(*chain[5], *chain[4], 1); // 4 and 5 form a loop and must stay together
+
+	graph::alg::PartitionOptions options;
+	options.parts = 3;
+	options.acyclic = true;
+	options.imbalance = 0.2;
+	auto result = graph::alg::partition(graph, options);
+	REQUIRE(result.part[*chain[4]] == result.part[*chain[5]]);
+	for (int i = 0; i + 1 < 12; i++)
+		REQUIRE(result.part[*chain[i]] <= result.part[*chain[i + 1]]);
+	REQUIRE(result.part[*chain[0]] == 0);
+	REQUIRE(result.part[*chain[11]] == 2);
+	REQUIRE(result.cutEdges == 2);
+}
+
+TEST_CASE("test task graph executor", "Graph") {
+	Graph graph;
+	std::vector<Vertex*> tasks;
+	for (int i = 0; i < 64; i++) tasks.push_back(&graph.newVertex());
+	for (int i = 1; i < 64; i++) {
+		graph.newEdge(*tasks[(i - 1) / 2], *tasks[i], 1); // Fan out as a binary tree
+		if (i % 3 == 0) graph.newEdge(*tasks[i - 1], *tasks[i], 1);
+	}
+	Vertex& ignored = graph.newVertex();
+	graph.newEdge(*tasks[63], ignored, 1);
+	graph.newEdge(ignored, *tasks[0], 0); // Not followed, so no cycle
+
+	std::mutex mutex;
+	VertexBindingMap<uint32_t> finished;
+	graph::exec::Executor executor(4);
+	executor.run(graph, [&](const Vertex& vertex) {
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.emplace(vertex, static_cast<uint32_t>(finished.size()));
+	});
+	REQUIRE(finished.size() == 65);
+	for (const Vertex& vertex : graph.vertices())
+		for (const Edge& edge : vertex.outEdges())
+			if (edge.weight()) REQUIRE(finished[vertex] < finished[edge.to()]);
+
+	// Nothing downstream of a failed task runs
+	std::atomic<bool> downstream{ false };
+	REQUIRE_THROWS_AS(executor.run(graph, [&](const Vertex& vertex) {
+		if (&vertex == tasks[1]) throw std::runtime_error("task failed");
+		if (&vertex == tasks[3] || &vertex == tasks[63] || &vertex == &ignored) downstream = true;
+	}), std::runtime_error);
+	REQUIRE(!downstream);
+
+	graph.newEdge(ignored, *tasks[0], 1);
+	REQUIRE_THROWS_AS(executor.run(graph, [](const Vertex&) {}), std::invalid_argument);
+}
+
+TEST_CASE("test incremental evaluation", "Graph") {
+	Graph graph;
+	Vertex& a = graph.newVertex();
+	Vertex& b = graph.newVertex();
+	Vertex& c = graph.newVertex();
+	Vertex& d = graph.newVertex();
+	Vertex& e = graph.newVertex();
+	Vertex& f = graph.newVertex();
+	graph.newEdge(a, b, 1);
+	graph.newEdge(b, c, 1);
+	graph.newEdge(a, d, 1);
+	graph.newEdge(d, e, 1);
+	graph.newEdge(c, e, 1);
+
+	graph::exec::IncrementalEvaluator evaluator(graph);
+	evaluator.markChanged(a);
+	auto cone = evaluator.affected();
+	REQUIRE(cone.size() == 5);
+	REQUIRE(cone[0] == a);
+	REQUIRE(cone[4] == e);
+
+	VertexBindingVec executed;
+	size_t count = evaluator.evaluate([&](const Vertex& vertex) {
+		executed.push_back(vertex);
+		return &vertex != &b; // b produces the same output, so c is skipped
+	});
+	REQUIRE(count == 4);
+	REQUIRE(executed.size() == 4);
+	REQUIRE(executed[0] == a);
+	REQUIRE(executed[3] == e);
+	REQUIRE(std::find(executed.begin(), executed.end(), Ref<const Vertex>(c)) == executed.end());
+	REQUIRE(std::find(executed.begin(), executed.end(), Ref<const Vertex>(f)) == executed.end());
+	REQUIRE(!evaluator.changed(a));
+	REQUIRE(evaluator.evaluate([](const Vertex&) { return true; }) == 0);
+}
+
+TEST_CASE("test dataflow solver", "Graph") {
+	using namespace graph::alg;
+	Graph graph;
+	Vertex& entry = graph.newVertex();
+	Vertex& head = graph.newVertex();
+	Vertex& body = graph.newVertex();
+	Vertex& exit = graph.newVertex();
+	graph.newEdge(entry, head, 1);
+	graph.newEdge(head, body, 1);
+	graph.newEdge(body, head, 1);
+	graph.newEdge(body, exit, 1);
+	CsrGraph csr(graph);
+	Graph other;
+	Vertex& stranger = other.newVertex();  // Same id as entry
+	REQUIRE_THROWS_AS(csr.id(stranger), std::out_of_range);
+
+	// Reaching definitions: d0 = x in entry, d1 = y in head, d2 = x in body
+	std::vector<BitVector> gen(4, BitVector(3)), kill(4, BitVector(3));
+	gen[csr.id(entry)].set(0);
+	kill[csr.id(entry)].set(2);
+	gen[csr.id(head)].set(1);
+	gen[csr.id(body)].set(2);
+	kill[csr.id(body)].set(0);
+	auto reaching = solveGenKill(csr, Direction::Forward, Confluence::Union, gen, kill, BitVector(3));
+	const BitVector& headIn = reaching.in[csr.id(head)];
+	REQUIRE(headIn.count() == 3);
+	const BitVector& exitIn = reaching.in[csr.id(exit)];
+	REQUIRE(!exitIn.test(0));
+	REQUIRE(exitIn.test(1));
+	REQUIRE(exitIn.test(2));
+
+	// Shortest distance to exit going backward, meet is min
+	auto distance = solveDataflow(csr, Direction::Backward, UINT32_MAX, 0u,
+		[](uint32_t, const uint32_t& in, uint32_t& out) {
+			const uint32_t next = in == UINT32_MAX ? in : in + 1;
+			if (next == out) return false;
+			out = next;
+			return true;
+		},
+		[](uint32_t& into, const uint32_t& from) { into = std::min(into, from); });
+	REQUIRE(distance.out[csr.id(exit)] == 1);
+	REQUIRE(distance.out[csr.id(body)] == 2);
+	REQUIRE(distance.out[csr.id(head)] == 3);
+	REQUIRE(distance.out[csr.id(entry)] == 4);
+}
+
+TEST_CASE("test graph generators", "Graph") {
+	auto edgeList = [](const std::vector<Vertex*>& vertices) {
+		VertexBindingMap<uint32_t> index;
+		for (uint32_t i = 0; i < vertices.size(); i++) index[*vertices[i]] = i;
+		std::vector<std::pair<uint32_t, uint32_t>> edges;
+		for (const Vertex* vertex : vertices)
+			for (const Edge& edge : vertex->outEdges()) edges.emplace_back(index[edge.from()], index[edge.to()]);
+		return edges;
+	};
+
+	graph::gen::GeneratorOptions serial, parallel;
+	serial.seed = parallel.seed = 7;
+	parallel.threads = 4;
+	Graph g1, g2;
+	auto v1 = graph::gen::erdosRenyi(g1, 1000, 200000, serial);
+	auto v2 = graph::gen::erdosRenyi(g2, 1000, 200000, parallel);
+	REQUIRE(edgeList(v1).size() == 200000);
+	REQUIRE(edgeList(v1) == edgeList(v2));
+
+	Graph planted;
+	auto vertices = graph::gen::plantedSccs(planted, 100, 10, 300);
+	auto color = graph::alg::strongly(planted);
+	for (uint32_t i = 0; i < 100; i++) {
+		REQUIRE(color[*vertices[i]] == color[*vertices[i - i % 10]]);
+		if (i >= 10) REQUIRE(color[*vertices[i]] != color[*vertices[i - 10]]);
+	}
+
+	Graph layered;
+	graph::gen::layeredDag(layered, 20, 30, 3, 0.8);
+	auto [rank, loops] = graph::alg::rank(layered);
+	REQUIRE(loops.empty());
+
+	Graph dag1, dag2;
+	REQUIRE(edgeList(graph::gen::randomDag(dag1, 500, 3, serial)) == edgeList(graph::gen::randomDag(dag2, 500, 3, parallel)));
+	REQUIRE(std::get<1>(graph::alg::rank(dag1)).empty());
+	Graph scaleFree, paths;
+	REQUIRE(edgeList(graph::gen::powerLaw(scaleFree, 100, 2)).size() == 99 * 2);
+	REQUIRE(edgeList(graph::gen::chains(paths, 10, 4)).size() == 7);
+	REQUIRE_THROWS_AS(graph::gen::rmat(paths, 32, 1), std::invalid_argument);
+}
+
+TEST_CASE("test bulk insertion", "Graph") {
+	Graph graph;
+	graph.reserve(100, 1000);
+	auto vertices = graph.addVertices(100);
+	REQUIRE(vertices.size() == 100);
+	REQUIRE(&vertices[99] - &vertices[0] == 99);
+	std::vector<EdgeSpec> specs;
+	for (int i = 0; i < 100; i++)
+		for (int j = 1; j <= 10; j++) specs.push_back({ vertices[i], vertices[(i * 7 + j) % 100], j });
+	auto edges = graph.addEdges(specs, 4);
+	REQUIRE(edges.size() == 1000);
+
+	uint32_t count = 0;
+	for (Vertex& vertex : vertices) {
+		int expectWeight = 1;
+		for (const Edge& edge : vertex.outEdges()) {
+			REQUIRE(&edge.from() == &vertex);
+			REQUIRE(edge.weight() == expectWeight++); // Out lists keep spec order
+			count++;
+		}
+		for (const Edge& edge : vertex.inEdges()) REQUIRE(&edge.to() == &vertex);
+	}
+	REQUIRE(count == 1000);
+
+	edges[0].remove();
+	REQUIRE(&vertices[0].outEdges().front() == &edges[1]);
+	Vertex& extra = graph.newVertex();
+	graph.newEdge(extra, vertices[0], 1);
+	REQUIRE(std::distance(graph.vertices().begin(), graph.vertices().end()) == 101);
+}
+
+TEST_CASE("test binary graph file", "Graph") {
+	using namespace graph::alg;
+	Graph graph;
+	auto vertices = graph::gen::plantedSccs(graph, 40, 4, 30);
+	const CsrGraph csr(graph);
+	std::vector<double> cost(csr.vertexCount());
+	for (uint32_t i = 0; i < csr.vertexCount(); i++) cost[i] = i * 0.5;
+	std::vector<uint32_t> flags(csr.edgeCount(), 7);
+	const std::string path = tempPath(".bin");
+	graph::io::writeGraph(path, csr, {
+		{ "cost", graph::io::ColumnKind::Vertex, graph::io::ColumnType::Float64, cost.data() },
+		{ "flags", graph::io::ColumnKind::Edge, graph::io::ColumnType::UInt32, flags.data() } });
+
+	const graph::io::MappedGraph mapped(path);
+	const CsrGraph& view = mapped.graph();
+	REQUIRE(!view.hasVertices());
+	REQUIRE(view.vertexCount() == csr.vertexCount());
+	REQUIRE(view.edgeCount() == csr.edgeCount());
+	for (uint32_t i = 0; i < csr.vertexCount(); i++) {
+		REQUIRE(std::equal(view.outTargets(i).begin(), view.outTargets(i).end(), csr.outTargets(i).begin(), csr.outTargets(i).end()));
+		REQUIRE(std::equal(view.inSources(i).begin(), view.inSources(i).end(), csr.inSources(i).begin(), csr.inSources(i).end()));
+	}
+	auto [component, sizes] = stronglyConnected(view);
+	REQUIRE(sizes.size() == 10);
+	REQUIRE(component[csr.id(*vertices[0])] == component[csr.id(*vertices[3])]);
+	REQUIRE(component[csr.id(*vertices[3])] != component[csr.id(*vertices[4])]);
+
+	REQUIRE(mapped.hasColumn("cost"));
+	REQUIRE(mapped.column<double>("cost", graph::io::ColumnKind::Vertex)[3] == 1.5);
+	REQUIRE(mapped.column<uint32_t>("flags", graph::io::ColumnKind::Edge).size() == csr.edgeCount());
+	REQUIRE_THROWS_AS(mapped.column<int32_t>("cost", graph::io::ColumnKind::Vertex), std::out_of_range);
+
+	// Crafted files: a column count whose table size wraps, a target past the last vertex
+	auto patch = [&path](std::streamoff at, uint64_t value, size_t bytes) {
+		std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(at);
+		file.write(reinterpret_cast<const char*>(&value), bytes);
+	};
+	auto readAt = [&path](std::streamoff at) {
+		uint64_t value = 0;
+		std::ifstream file(path, std::ios::binary);
+		file.seekg(at);
+		file.read(reinterpret_cast<char*>(&value), sizeof(value));
+		return value;
+	};
+	const uint64_t columnCount = readAt(80);
+	patch(80, UINT64_MAX / 72 + 1, 8);  // Times sizeof(ColumnEntry) is 56
+	REQUIRE_THROWS_AS(graph::io::MappedGraph(path), std::runtime_error);
+	patch(80, columnCount, 8);
+	REQUIRE_NOTHROW(graph::io::MappedGraph(path));
+	// A 64-bit column off its alignment, in rows that do not mirror the out rows
+	const std::streamoff costOffset = static_cast<std::streamoff>(readAt(88)) + 56;
+	const uint64_t cost64 = readAt(costOffset);
+	patch(costOffset, cost64 + 4, 8);
+	REQUIRE_THROWS_AS(graph::io::MappedGraph(path), std::runtime_error);
+	patch(costOffset, cost64, 8);
+	const std::streamoff source = static_cast<std::streamoff>(readAt(64));
+	const uint32_t first = static_cast<uint32_t>(readAt(source));
+	patch(source, (first + 1) % csr.vertexCount(), 4);
+	REQUIRE_THROWS_AS(graph::io::MappedGraph(path), std::runtime_error);
+	patch(source, first, 4);
+	REQUIRE_NOTHROW(graph::io::MappedGraph(path));
+	patch(static_cast<std::streamoff>(readAt(40)), 1000000, 4);
+	REQUIRE_THROWS_AS(graph::io::MappedGraph(path), std::runtime_error);
+	std::remove(path.c_str());
+	REQUIRE_THROWS_AS(graph::io::MappedGraph(path), std::runtime_error);
+}
+TEST_CASE("test edge list and DOT readers", "Graph") {
+	const std::string path = tempPath(".txt");
+	auto write = [&path](const std::string& text) { std::ofstream(path, std::ios::trunc) << text; };
+	auto outWeight = [](const Vertex* from, const Vertex* to) {
+		for (const Edge& edge : from->outEdges())
+			if (&edge.to() == to) return edge.weight();
+		return -1;
+	};
+
+	write("# comment\nb a 3\na c\n\nd\nc\tb -2\n");
+	Graph graph;
+	auto list = graph::io::readEdgeList(path, graph, { 1, 5 });
+	REQUIRE(list.names == std::vector<std::string>{ "b", "a", "c", "d" });
+	REQUIRE(outWeight(list.vertices[0], list.vertices[1]) == 3);
+	REQUIRE(outWeight(list.vertices[1], list.vertices[2]) == 5);
+	REQUIRE(outWeight(list.vertices[2], list.vertices[0]) == -2);
+	REQUIRE(list.vertices[3]->outEdges().empty());
+
+	write("strict digraph G {\n  node [shape=box];\n  rankdir = LR\n  /* block */ \"x y\" -> b -> c [weight=4, color=red]\n"
+		"  subgraph s { c -> \n d }\n  d:p1 -> \"x y\" // tail\n}\n");
+	Graph dot;
+	auto named = graph::io::readDot(path, dot);
+	REQUIRE(named.names == std::vector<std::string>{ "x y", "b", "c", "d" });
+	REQUIRE(outWeight(named.vertices[0], named.vertices[1]) == 4);
+	REQUIRE(outWeight(named.vertices[1], named.vertices[2]) == 4);
+	REQUIRE(outWeight(named.vertices[2], named.vertices[3]) == 1);
+	REQUIRE(outWeight(named.vertices[3], named.vertices[0]) == 1);
+
+	// Large enough to be split, the result must match a single threaded parse
+	std::string big = "digraph {\n";
+	for (uint32_t i = 0; i < 60000; i++)
+		big += "n" + std::to_string(i * 7919 % 60000) + " -> \"n" + std::to_string(i) + "\"\n  [weight=" + std::to_string(i % 9) + "]\n";
+	write(big + "}\n");
+	Graph serial, parallel;
+	auto one = graph::io::readDot(path, serial, { 1 });
+	auto many = graph::io::readDot(path, parallel, { 4 });
+	REQUIRE(one.names == many.names);
+	for (size_t i = 0; i < one.vertices.size(); i++) {
+		const auto& a = one.vertices[i]->outEdges();
+		const auto& b = many.vertices[i]->outEdges();
+		REQUIRE(std::distance(a.begin(), a.end()) == std::distance(b.begin(), b.end()));
+		for (auto x = a.begin(), y = b.begin(); x != a.end(); ++x, ++y) REQUIRE(x->weight() == y->weight());
+	}
+
+	// A split between subgraph and its name would turn the name into a vertex
+	big = "digraph {\n";
+	for (uint32_t i = 0; i < 40000; i++)
+		big += "subgraph\ncluster" + std::to_string(i) + " { subgraphs" + std::to_string(i) + " -> x }\n";
+	write(big + "}\n");
+	Graph clusters;
+	auto split = graph::io::readDot(path, clusters, { 4 });
+	REQUIRE(split.names.size() == 40001);
+	REQUIRE(std::none_of(split.names.begin(), split.names.end(), [](const std::string& name) { return name.rfind("cluster", 0) == 0; }));
+
+	write("a b\nc d e f\n");
+	Graph bad;
+	REQUIRE_THROWS_WITH(graph::io::readEdgeList(path, bad), Catch::Contains(":2: too many fields"));
+	write("digraph { a -> ; }");
+	REQUIRE_THROWS_WITH(graph::io::readDot(path, bad), Catch::Contains(":1: expected node name"));
+	std::remove(path.c_str());
+}
+
+TEST_CASE("test DOT and GraphML writers", "Graph") {
+	using namespace graph::alg;
+	const std::string path = tempPath(".dot");
+	auto read = [&path] {
+		std::ostringstream text;
+		text << std::ifstream(path).rdbuf();
+		return text.str();
+	};
+	Graph graph;
+	auto vertices = graph::gen::plantedSccs(graph, 40, 4, 30);
+	const CsrGraph csr(graph);
+	std::vector<std::string> names;
+	for (uint32_t i = 0; i < csr.vertexCount(); i++) names.push_back(i % 2 ? "v" + std::to_string(i) : "node \"" + std::to_string(i) + "\"");
+	auto [component, sizes] = stronglyConnected(csr);
+
+	graph::io::writeDot(path, csr, { &names, &component, &component });
+	Graph copy;
+	auto named = graph::io::readDot(path, copy);
+	REQUIRE(named.vertices.size() == csr.vertexCount());
+	REQUIRE(named.names[1] == "v1");
+	REQUIRE(named.names[0] == "node \\\"0\\\"");
+	for (uint32_t i = 0; i < csr.vertexCount(); i++) {
+		const auto& out = named.vertices[i]->outEdges();
+		REQUIRE(static_cast<size_t>(std::distance(out.begin(), out.end())) == csr.outTargets(i).size());
+	}
+	REQUIRE(read().find("{ rank=same; \"node \\\"0\\\"\"; v1; \"node \\\"2\\\"\"; v3; }") != std::string::npos);
+
+	// Group of vertex 0 is 0..3, the neighborhood also reaches the ring neighbors of vertex 0
+	const auto group = graph::io::selectComponent(component, component[csr.id(*vertices[0])]);
+	REQUIRE(std::count(group.begin(), group.end(), true) == 4);
+	const auto near = graph::io::selectNeighborhood(csr, { 0 }, 1);
+	REQUIRE(near[1]);
+	REQUIRE(near[3]);
+	REQUIRE(!near[2]);
+	graph::io::writeDot(path, csr, { nullptr, nullptr, nullptr, &group });
+	const std::string dot = read();
+	size_t inside = 0;
+	for (uint32_t i = 0; i < csr.vertexCount(); i++)
+		for (const uint32_t to : csr.outTargets(i)) inside += group[i] && group[to];
+	REQUIRE(static_cast<size_t>(std::count(dot.begin(), dot.end(), '>')) == inside);
+	REQUIRE(inside >= 4);
+	REQUIRE(dot.find("n0 -> n1 [weight=1];") != std::string::npos);
+
+	// Streaming from the graph writes what its snapshot would, also with gaps in the ids
+	vertices[5]->remove();
+	graph::io::writeDot(path, CsrGraph(graph), { nullptr, nullptr, nullptr, &group });
+	const std::string fromSnapshot = read();
+	graph::io::writeDot(path, graph, { nullptr, nullptr, nullptr, &group });
+	REQUIRE(read() == fromSnapshot);
+
+	graph::io::writeGraphML(path, csr, { &names, &component, nullptr, &group });
+	const std::string xml = read();
+	REQUIRE(xml.find("<node id=\"node &quot;0&quot;\"><data key=\"color\">") != std::string::npos);
+	REQUIRE(xml.find("<edge source=\"node &quot;0&quot;\" target=\"v1\"><data key=\"weight\">1</data></edge>") != std::string::npos);
+	std::remove(path.c_str());
+}
+
+TEST_CASE("test shared memory snapshot", "Graph") {
+	using namespace graph::alg;
+	Graph graph;
+	graph::gen::plantedSccs(graph, 200, 5, 300);
+	const CsrGraph csr(graph);
+	std::vector<uint32_t> tag(csr.vertexCount());
+	for (uint32_t i = 0; i < csr.vertexCount(); i++) tag[i] = i * 3;
+	const std::string name = "/libgraph_test_" + std::to_string(::getpid());
+	graph::io::publishGraph(name, csr, { { "tag", graph::io::ColumnKind::Vertex, graph::io::ColumnType::UInt32, tag.data() } });
+
+	// A forked reader works on the published arrays directly
+	const pid_t child = ::fork();
+	if (child == 0) {
+		const auto shared = graph::io::MappedGraph::attach(name);
+		auto [component, sizes] = stronglyConnected(shared.graph());
+		const bool ok = sizes.size() == 40 && shared.column<uint32_t>("tag", graph::io::ColumnKind::Vertex)[7] == 21;
+		::_exit(ok ? 0 : 1);
+	}
+	int status = -1;
+	::waitpid(child, &status, 0);
+	REQUIRE(WIFEXITED(status));
+	REQUIRE(WEXITSTATUS(status) == 0);
+
+	const auto shared = graph::io::MappedGraph::attach(name);
+	REQUIRE(shared.graph().edgeCount() == csr.edgeCount());
+	REQUIRE(std::equal(shared.graph().outTargets(5).begin(), shared.graph().outTargets(5).end(), csr.outTargets(5).begin()));
+
+	// Republishing replaces the object, the old view stays intact
+	Graph small;
+	graph::gen::plantedSccs(small, 10, 5, 0);
+	graph::io::publishGraph(name, CsrGraph(small));
+	REQUIRE(graph::io::MappedGraph::attach(name).graph().vertexCount() == 10);
+	REQUIRE(shared.graph().vertexCount() == 200);
+	graph::io::unpublishGraph(name);
+	REQUIRE_THROWS_AS(graph::io::MappedGraph::attach(name), std::runtime_error);
+}
+
+TEST_CASE("test graph move and swap", "Graph") {
+	auto make = [](uint32_t size) {
+		Graph graph;
+		graph::gen::plantedSccs(graph, size, 4, size);
+		return graph;
+	};
+	auto count = [](const Graph& graph) { return std::distance(graph.vertices().begin(), graph.vertices().end()); };
+	Graph a = make(40);
+	Graph b = make(12);
+	Vertex& first = const_cast<Vertex&>(a.vertices().front());
+	swap(a, b);
+	REQUIRE(count(a) == 12);
+	REQUIRE(count(b) == 40);
+
+	// Removal after a move unlinks from the list now owned by the new object
+	Graph c(std::move(b));
+	REQUIRE(count(b) == 0);
+	first.remove();
+	REQUIRE(count(c) == 39);
+	for (const Vertex& vertex : c.vertices())
+		for (const Edge& edge : vertex.outEdges()) REQUIRE(&edge.to() != &first);
+	c.newEdge(c.newVertex(), const_cast<Vertex&>(c.vertices().front()), 1);
+	REQUIRE(count(c) == 40);
+
+	a = std::move(c);
+	REQUIRE(count(a) == 40);
+	REQUIRE(count(c) == 0);
+	auto [component, sizes] = graph::alg::weaklyConnected(a);
+	REQUIRE(component.size() == 40);
+}
+
+TEST_CASE("test clone and subgraph extraction", "Graph") {
+	Graph graph;
+	auto vertices = graph::gen::plantedSccs(graph, 40, 4, 60);
+	vertices[5]->remove();
+	const_cast<Edge&>(vertices[8]->outEdges().front()).remove();
+	graph.newEdge(*vertices[9], *vertices[0], 7);
+
+	auto edges = [](const Graph& g) {
+		// (from position, to position, weight) in out list order, plus in list order
+		std::map<const Vertex*, size_t> position;
+		for (const Vertex& vertex : g.vertices()) position.emplace(&vertex, position.size());
+		std::vector<std::tuple<size_t, size_t, int>> result;
+		for (const Vertex& vertex : g.vertices()) {
+			for (const Edge& edge : vertex.outEdges()) result.emplace_back(position[&edge.from()], position[&edge.to()], edge.weight());
+			for (const Edge& edge : vertex.inEdges()) result.emplace_back(position[&edge.from()], position[&edge.to()], -edge.weight());
+		}
+		return result;
+	};
+	const Graph copy = graph.clone();
+	REQUIRE(std::distance(copy.vertices().begin(), copy.vertices().end()) == 39);
+	REQUIRE(edges(copy) == edges(graph));
+
+	// Even vertices and the edges of weight 1 between them
+	std::set<const Vertex*> even;
+	for (size_t i = 0; i < vertices.size(); i += 2) even.insert(vertices[i]);
+	auto [sub, mapping] = graph::core::extractSubgraph(graph, [&](const Vertex& v) { return even.count(&v) > 0; },
+		[](const Edge& e) { return e.weight() == 1; });
+	REQUIRE(mapping.size() == 39);
+	REQUIRE(mapping[0] != nullptr);
+	REQUIRE(mapping[1] == nullptr);
+	REQUIRE(mapping[5] != nullptr);  // vertices[6], positions shift after the removal
+	REQUIRE(mapping[6] == nullptr);
+	REQUIRE(std::distance(sub.vertices().begin(), sub.vertices().end()) == 20);
+	size_t expect = 0;
+	for (const Vertex& vertex : graph.vertices())
+		for (const Edge& edge : vertex.outEdges()) expect += even.count(&edge.from()) && even.count(&edge.to()) && edge.weight() == 1;
+	size_t found = 0;
+	for (const Vertex& vertex : sub.vertices()) found += std::distance(vertex.outEdges().begin(), vertex.outEdges().end());
+	REQUIRE(found == expect);
+
+	// Zero weight edges are not followed, as in the algorithms, but a clone keeps them
+	graph.newEdge(*vertices[0], *vertices[2], 0);
+	auto [followed, unused] = graph::core::extractSubgraph(graph, nullptr, graph::alg::followAlwaysTrue);
+	REQUIRE(edges(followed).size() == edges(graph).size() - 2);
+	REQUIRE(edges(graph.clone()) == edges(graph));
+
+	// Copies only read the graph, so readers on several threads see the same result
+	const auto expected = edges(graph);
+	std::vector<std::thread> readers;
+	std::atomic<size_t> same{ 0 };
+	for (int t = 0; t < 4; t++)
+		readers.emplace_back([&] {
+			for (int i = 0; i < 20; i++) same += edges(graph.clone()) == expected;
+		});
+	for (auto& reader : readers) reader.join();
+	REQUIRE(same == 80);
+}
+
+TEST_CASE("test graph absorb", "Graph") {
+	std::vector<Graph> modules(3);
+	std::vector<std::vector<Vertex*>> vertices(modules.size());
+	std::vector<std::thread> threads;
+	for (size_t m = 0; m < modules.size(); m++)
+		threads.emplace_back([&, m] { vertices[m] = graph::gen::plantedSccs(modules[m], 20, 5, 10, { m + 1 }); });
+	for (auto& thread : threads) thread.join();
+
+	Graph top;
+	Vertex& root = top.newVertex();
+	for (size_t m = 0; m < modules.size(); m++) {
+		// Ids of the absorbed elements move past ours, a pass over all of them
+		const uint32_t before = top.vertexIdCount();
+		const uint32_t id = vertices[m][0]->id();
+		top.absorb(std::move(modules[m]));
+		REQUIRE(modules[m].vertices().empty());
+		REQUIRE(vertices[m][0]->id() == before + id);
+		top.newEdge(root, *vertices[m][0], 1);
+		top.newEdge(*vertices[m][19], root, 1);
+	}
+	REQUIRE(std::distance(top.vertices().begin(), top.vertices().end()) == 61);
+	REQUIRE(&*std::next(top.vertices().begin()) == vertices[0][0]);
+	const uint32_t ids = top.vertexIdCount();
+	top.absorb(std::move(top));  // A graph absorbing itself keeps everything
+	REQUIRE(std::distance(top.vertices().begin(), top.vertices().end()) == 61);
+	REQUIRE(top.vertexIdCount() == ids);
+	auto [component, sizes] = graph::alg::weaklyConnected(top);
+	REQUIRE(sizes.size() == 1);
+	const Graph copy = top.clone();
+	REQUIRE(std::distance(copy.vertices().begin(), copy.vertices().end()) == 61);
+	vertices[1][3]->remove();
+	modules[0].newVertex();  // Absorbed graphs stay usable
+	REQUIRE(std::distance(top.vertices().begin(), top.vertices().end()) == 60);
+}
+
+TEST_CASE("test concurrent graph builder", "Graph") {
+	constexpr unsigned threads = 4;
+	constexpr uint32_t perThread = 500;
+	GraphBuilder builder(threads);
+	std::vector<std::vector<Vertex*>> vertices(threads);
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; t++)
+		workers.emplace_back([&, t] {
+			auto& local = builder.local(t);
+			for (uint32_t i = 0; i < perThread; i++) vertices[t].push_back(&local.newVertex());
+			for (uint32_t i = 0; i + 1 < perThread; i++) local.newEdge(*vertices[t][i], *vertices[t][i + 1], static_cast<int>(i));
+		});
+	for (auto& worker : workers) worker.join();
+	// Cross edges between the per thread chains, made after all vertices exist
+	for (unsigned t = 0; t < threads; t++) builder.local(t).newEdge(*vertices[t][perThread - 1], *vertices[(t + 1) % threads][0], -1);
+
+	Graph graph = builder.finish(3);
+	REQUIRE(std::distance(graph.vertices().begin(), graph.vertices().end()) == threads * perThread);
+	REQUIRE(&graph.vertices().front() == vertices[0][0]);
+	int expect = 0;
+	for (const Edge& edge : vertices[1][7]->outEdges()) REQUIRE(edge.weight() == 7 + expect++);
+	REQUIRE(expect == 1);
+	REQUIRE(vertices[2][0]->inEdges().front().weight() == -1);
+	REQUIRE(&vertices[3][perThread - 1]->outEdges().front().to() == vertices[0][0]);
+	auto [component, sizes] = graph::alg::stronglyConnected(graph::alg::CsrGraph(graph));
+	REQUIRE(sizes.size() == 1);
+
+	// Ids stay dense across the merged Locals
+	std::set<uint32_t> vertexIds, edgeIds;
+	for (const Vertex& vertex : graph.vertices()) {
+		vertexIds.insert(vertex.id());
+		for (const Edge& edge : vertex.outEdges()) edgeIds.insert(edge.id());
+	}
+	REQUIRE(vertexIds.size() == graph.vertexIdCount());
+	REQUIRE(*vertexIds.rbegin() == graph.vertexIdCount() - 1);
+	REQUIRE(edgeIds.size() == graph.edgeIdCount());
+	REQUIRE(*edgeIds.rbegin() == graph.edgeIdCount() - 1);
+
+	// Edges removed before finish() stay out of the lists, layers are kept
+	GraphBuilder layered(2);
+	Vertex& a = layered.local(0).newVertex();
+	Vertex& b = layered.local(1).newVertex();
+	layered.local(0).newEdge(a, b, 1).remove();
+	layered.local(1).newEdge(a, b, 2, 3);
+	layered.local(1).newEdge(b, a, 3);
+	REQUIRE_THROWS_AS(layered.local(0).newEdge(a, b, 1, edgeLayers), std::invalid_argument);
+	Graph built = layered.finish(2);
+	REQUIRE(a.outEdges().empty());
+	REQUIRE(b.inEdges().empty());
+	REQUIRE(a.outEdges(3).front().weight() == 2);
+	REQUIRE(b.outEdges().front().weight() == 3);
+
+	// So are the edges of vertices removed before finish(), with one or more threads
+	for (unsigned threads : { 1u, 3u }) {
+		GraphBuilder pruned(2);
+		Vertex& from = pruned.local(0).newVertex();
+		Vertex& kept = pruned.local(1).newVertex();
+		Vertex& gone = pruned.local(1).newVertex();
+		pruned.local(0).newEdge(from, gone, 1);
+		pruned.local(1).newEdge(gone, kept, 2);
+		pruned.local(1).newEdge(from, kept, 3);
+		gone.remove();
+		Graph result = pruned.finish(threads);
+		REQUIRE(from.outDegree() == 1);
+		REQUIRE(from.outEdges().front().weight() == 3);
+		REQUIRE(gone.inEdges().empty());
+		REQUIRE(gone.outEdges().empty());
+		REQUIRE(graph::alg::strongly(result).size() == 2);
+		REQUIRE(graph::alg::CsrGraph(result).edgeCount() == 1);
+	}
+}
+
+TEST_CASE("test snapshots for concurrent readers", "Graph") {
+	using namespace graph::alg;
+	Graph graph;
+	auto vertices = graph::gen::plantedSccs(graph, 200, 1, 0);
+	SnapshotPublisher publisher(graph);
+	std::weak_ptr<const Snapshot> first = publisher.current();
+
+	// Every published version adds one chain edge, so version v has v - 1 edges and 201 - v components
+	std::atomic<bool> done{ false };
+	std::atomic<uint32_t> checked{ 0 };
+	std::atomic<bool> consistent{ true };
+	std::thread reader([&] {
+		uint64_t last = 0;
+		while (!done) {
+			const auto snapshot = publisher.current();
+			auto [component, sizes] = weaklyConnected(snapshot->graph);
+			if (snapshot->version < last || snapshot->graph.edgeCount() != snapshot->version - 1 || sizes.size() != 201 - snapshot->version)
+				consistent = false;
+			last = snapshot->version;
+			checked++;
+		}
+	});
+	for (uint32_t i = 0; i + 1 < 100; i++) {
+		graph.newEdge(*vertices[i], *vertices[i + 1], 1);
+		REQUIRE(publisher.publish() == i + 2);
+	}
+	while (checked < 10) std::this_thread::yield();
+	done = true;
+	reader.join();
+	REQUIRE(consistent);
+	REQUIRE(first.expired());
+	REQUIRE(publisher.current()->graph.edgeCount() == 99);
+}
+
+TEST_CASE("test concurrent algorithms", "Graph") {
+	Graph graph;
+	auto vertices = graph::gen::plantedSccs(graph, 10, 1, 0);
+	graph.newEdge(*vertices[0], *vertices[1], 1);
+	const uint32_t color = graph::alg::strongly(graph)[*vertices[0]];
+
+	// Work arrays are per call, so readers of one graph do not share state
+	std::vector<std::thread> threads;
+	std::vector<uint32_t> ranks(4), colors(4);
+	for (unsigned t = 0; t < 4; t++)
+		threads.emplace_back([&, t] {
+			ranks[t] = std::get<0>(graph::alg::rank(graph))[*vertices[1]];
+			colors[t] = graph::alg::strongly(graph)[*vertices[0]];
+		});
+	for (auto& thread : threads) thread.join();
+	REQUIRE(ranks == std::vector<uint32_t>(4, 2));
+	REQUIRE(colors == std::vector<uint32_t>(4, color));
+}
+
+TEST_CASE("test graph with inline payloads", "Graph") {
+	struct Cost {
+		double weight;
+		bool critical;
+	};
+	using NetGraph = DataGraph<std::string, Cost>;
+	NetGraph graph;
+	auto& a = graph.newVertex("a");
+	auto& b = graph.newVertex(std::string_view("b"));
+	auto& c = graph.newVertex();
+	c.data = "c";
+	graph.newEdge(a, b, 1, 0.5, false);
+	graph.newEdge(b, c, 1, 2.25, true);
+	graph.newEdge(c, a, 1, 1.0, true);
+
+	// Algorithms see a plain Graph, callbacks get at the payloads directly
+	auto [component, sizes] = graph::alg::weaklyConnected(graph.graph(), [](const Edge& edge) { return !NetGraph::data(edge).critical; });
+	REQUIRE(sizes.size() == 2);
+	double total = 0;
+	for (const Vertex& vertex : graph.vertices())
+		for (const Edge& edge : vertex.outEdges()) total += NetGraph::data(edge).weight;
+	REQUIRE(total == 3.75);
+	REQUIRE(NetGraph::data(b.outEdges().front().to()) == "c");
+
+	NetGraph other;
+	auto& d = other.newVertex("d");
+	other.newEdge(d, d, 3, 0.0, true);
+	graph.absorb(std::move(other));
+	REQUIRE(d.id() == 3);
+	REQUIRE(d.outEdges().front().id() == 3);
+	graph.newEdge(c, d, 1, 1.0, false);
+	NetGraph moved(std::move(graph));
+	REQUIRE(NetGraph::data(moved.vertices().back()) == "d");
+	REQUIRE(std::distance(moved.vertices().begin(), moved.vertices().end()) == 4);
+	d.remove();
+	const Graph shape = moved.graph().clone();
+	REQUIRE(std::distance(shape.vertices().begin(), shape.vertices().end()) == 3);
+
+	DataGraph<> plain;
+	plain.newEdge(plain.newVertex(), plain.newVertex(), 1);
+	REQUIRE(std::distance(plain.vertices().begin(), plain.vertices().end()) == 2);
+	static_assert(!std::is_convertible_v<NetGraph&, Graph&>, "payload free insertion through the base");
+}
+
+TEST_CASE("test columnar attributes", "Graph") {
+	Graph graph;
+	auto vertices = graph::gen::erdosRenyi(graph, 100, 400, { 7 });
+	AttributeStore store(graph);
+	auto& weights = store.loadWeights();
+	REQUIRE(weights.size() == 400);
+	auto& cost = store.edgeColumn<double>("cost");
+	for (uint32_t i = 0; i < cost.size(); i++) cost[i] = i % 10;
+	transformColumn(cost, [](double c) { return c * 0.5; });
+	REQUIRE(reduceColumn(cost, 0.0, [](double a, double b) { return a + b; }) == 40 * 22.5);
+
+	// Only cheap edges, matching a walk with the same test on the edges themselves
+	const graph::alg::EdgeMask cheap(maskColumn(cost, [](double c) { return c < 2; }));
+	size_t followed = 0;
+	for (const Vertex& vertex : graph.vertices())
+		for (const Edge& edge : vertex.outEdges()) followed += cheap.test(edge) == (edge.id() % 10 < 4);
+	REQUIRE(followed == 400);
+	auto [component, sizes] = graph::alg::weaklyConnected(graph, cheap);
+	auto [all, allSizes] = graph::alg::weaklyConnected(graph);
+	REQUIRE(sizes.size() >= allSizes.size());
+
+	auto& level = store.vertexColumn<uint32_t>("level");
+	level[vertices[3]->id()] = 5;
+	graph.newVertex();
+	REQUIRE(store.vertexColumn<uint32_t>("level").size() == 101);
+	REQUIRE(store.vertexColumn<uint32_t>("level")[vertices[3]->id()] == 5);
+	const Mask top = maskColumn(store.vertexColumn<uint32_t>("level"), [](uint32_t l) { return l > 0; });
+	auto [sub, mapping] = extractSubgraph(graph, selectMask(top), nullptr);
+	REQUIRE(std::distance(sub.vertices().begin(), sub.vertices().end()) == 1);
+	REQUIRE_THROWS_AS(store.vertexColumn<double>("level"), std::invalid_argument);
+	store.erase("level");
+	REQUIRE(!store.hasVertexColumn("level"));
+
+	// Edges past the mask are not followed, recomputed weights go back into the edges
+	const Edge& late = graph.newEdge(*vertices[0], *vertices[1], 1);
+	REQUIRE(!cheap.test(late));
+	auto& recomputed = store.loadWeights();
+	transformColumn(recomputed, [](int32_t w) { return w * 3; });
+	store.storeWeights(graph);
+	REQUIRE(late.weight() == 3);
+	REQUIRE(vertices[0]->outEdges().front().weight() == 3 * graph::gen::GeneratorOptions{}.weight);
+	Graph stranger;
+	REQUIRE_THROWS_AS(store.storeWeights(stranger), std::invalid_argument);
+}
+
+TEST_CASE("test precomputed edge masks", "Graph") {
+	using namespace graph::alg;
+	Graph graph;
+	auto vertices = graph::gen::layeredDag(graph, 20, 10, 3, 0.5);
+	size_t calls = 0;
+	auto expensive = [&calls](const Edge& edge) {
+		calls++;
+		return edge.from().id() % 3 != 0;
+	};
+	const EdgeMask mask(graph, expensive);
+	REQUIRE(calls == 19 * 10 * 3);
+	calls = 0;
+	auto [maskRank, maskLoops] = rank(graph, mask);
+	REQUIRE(calls == 0);
+	for (const Vertex& vertex : graph.vertices()) REQUIRE(reportLoops(vertex, mask).empty());
+	REQUIRE(strongly(graph, mask) == strongly(graph, mask.func()));
+	REQUIRE(std::get<1>(weaklyConnected(graph, mask)) == std::get<1>(weaklyConnected(graph, mask.func())));
+	REQUIRE(calls == 0);
+	auto [rankDirect, loopsDirect] = rank(graph, expensive);
+	REQUIRE(maskRank == rankDirect);
+	REQUIRE(std::get<0>(rank(graph, mask.func())) == rankDirect);
+	for (const Vertex& vertex : graph.vertices()) reportLoops(vertex, expensive);
+	REQUIRE(calls > 2 * 19 * 10 * 3);
+
+	size_t followed = 0;
+	for (const Vertex& vertex : graph.vertices()) {
+		const auto degree = static_cast<size_t>(std::distance(vertex.outEdges().begin(), vertex.outEdges().end()));
+		REQUIRE(mask.countOut(vertex) == (vertex.id() % 3 ? degree : 0));
+		followed += mask.countOut(vertex);
+	}
+	REQUIRE(mask.count() == followed);
+
+	EdgeMask heavy(graph, [](const Edge& edge) { return edge.to().id() % 2 == 0; });
+	EdgeMask both = heavy;
+	both &= mask;
+	heavy |= mask;
+	REQUIRE(both.count() <= mask.count());
+	REQUIRE(heavy.count() >= mask.count());
+	Edge& late = graph.newEdge(*vertices[1], *vertices[2], 1);
+	REQUIRE(!mask.test(late));
+	REQUIRE_THROWS_AS(both &= EdgeMask(graph), std::invalid_argument);
+	REQUIRE_THROWS_AS(heavy |= EdgeMask(graph), std::invalid_argument);
+}
+
+TEST_CASE("test edge layers", "Graph") {
+	using namespace graph::alg;
+	Graph graph;
+	auto vertices = graph.addVertices(4);
+	graph.newEdge(vertices[0], vertices[1], 1);
+	Edge& typed = graph.newEdge(vertices[0], vertices[2], 2, 3);
+	graph.newEdge(vertices[1], vertices[2], 3);
+	graph.addEdges({ { vertices[2], vertices[3], 4, 3 }, { vertices[0], vertices[3], 5, 7 } });
+	REQUIRE_THROWS_AS(graph.newEdge(vertices[0], vertices[1], 1, edgeLayers), std::invalid_argument);
+	REQUIRE_THROWS_AS(vertices[0].inEdges(edgeLayers), std::invalid_argument);
+	REQUIRE_THROWS_AS(vertices[0].outEdges(edgeLayers), std::invalid_argument);
+	REQUIRE_THROWS_AS(vertices[0].forEachOutEdge(edgeLayers, [](const Edge&) {}), std::invalid_argument);
+
+	REQUIRE(std::distance(vertices[0].outEdges().begin(), vertices[0].outEdges().end()) == 1);
+	REQUIRE(vertices[0].outEdges(3).front().to().id() == vertices[2].id());
+	REQUIRE(vertices[0].outEdges(7).front().weight() == 5);
+	REQUIRE(vertices[3].outEdges(5).empty());
+	REQUIRE(vertices[2].inEdges(3).front().weight() == 2);
+	size_t total = 0;
+	for (const Vertex& vertex : graph.vertices()) vertex.forEachOutEdge([&total](const Edge&) { total++; });
+	REQUIRE(total == 5);
+
+	// Algorithms and default snapshots see layer 0 only
+	REQUIRE(CsrGraph(graph).edgeCount() == 2);
+	REQUIRE(CsrGraph(graph, followAlwaysTrue, 1u << 3).edgeCount() == 2);
+	REQUIRE(CsrGraph(graph, followAlwaysTrue, allLayers).edgeCount() == 5);
+	REQUIRE(EdgeMask(graph, followAlwaysTrue).count() == 5);
+
+	Graph copy = graph.clone();
+	REQUIRE(CsrGraph(copy, followAlwaysTrue, 1u << 3).edgeCount() == 2);
+	REQUIRE(CsrGraph(copy, followAlwaysTrue, 1u << 7).edgeCount() == 1);
+
+	// Algorithms take the layers to follow, closing 0 -> 2 -> 3 in layer 5 makes a loop there
+	Edge& back = graph.newEdge(vertices[3], vertices[0], 6, 5);
+	const LayerSet typedLayers = 1u << 3 | 1u << 5;
+	auto color = strongly(graph);
+	REQUIRE(!color[vertices[0]]);
+	color = strongly(graph, followAlwaysTrue, typedLayers);
+	REQUIRE(color[vertices[0]]);
+	REQUIRE(color[vertices[0]] == color[vertices[3]]);
+	REQUIRE(!color[vertices[1]]);
+	REQUIRE(strongly(graph, EdgeMask(graph), typedLayers) == color);
+	REQUIRE(reportLoops(vertices[0]).empty());
+	REQUIRE(reportLoops(vertices[0], followAlwaysTrue, typedLayers).size() == 4);
+	REQUIRE(std::get<1>(weaklyConnected(graph, followAlwaysTrue, 1u << 5)).size() == 3);
+	auto [ranks, loops] = rank(graph, followAlwaysTrue, 1, 1u << 3);
+	REQUIRE(ranks[vertices[3]] == ranks[vertices[0]] + 2);
+	REQUIRE(loops.empty());
+	REQUIRE(!std::get<1>(rank(graph, followAlwaysTrue, 1, typedLayers)).empty());
+	graph::exec::IncrementalEvaluator plain(graph), typedOnly(graph, followAlwaysTrue, 1u << 3);
+	plain.markChanged(vertices[0]);
+	typedOnly.markChanged(vertices[0]);
+	REQUIRE(plain.affected().size() == 3);
+	REQUIRE(plain.affected()[1].ptr()->id() == vertices[1].id());
+	REQUIRE(typedOnly.affected().size() == 3);
+	REQUIRE(typedOnly.affected()[2].ptr()->id() == vertices[3].id());
+	back.remove();
+
+	typed.remove();
+	REQUIRE(vertices[2].inEdges(3).empty());
+	vertices[0].removeEdges();
+	REQUIRE(vertices[3].inEdges(7).empty());
+	REQUIRE(CsrGraph(graph, followAlwaysTrue, allLayers).edgeCount() == 2);
+}
+
+TEST_CASE("test compact graph", "Graph") {
+	using namespace graph::alg;
+	static_assert(sizeof(Edge) >= 2 * 28, "compact edges should take at most half the space");
+	CompactGraph compact;
+	const uint32_t first = compact.addVertices(5);
+	REQUIRE(first == 0);
+	const uint32_t a = compact.newEdge(0, 1, 1);
+	compact.newEdge(1, 2, 2);
+	const uint32_t c = compact.newEdge(2, 0, 3);
+	compact.newEdge(0, 2, 4);
+	compact.newEdge(3, 4, 5);
+	REQUIRE_THROWS_AS(compact.newEdge(0, 5, 1), std::out_of_range);
+	REQUIRE(compact.edgeCount() == 5);
+
+	std::vector<uint32_t> targets;
+	compact.forEachOutEdge(0, [&](uint32_t edge) { targets.push_back(compact.to(edge)); });
+	REQUIRE(targets == std::vector<uint32_t>{ 1, 2 });
+
+	const CsrGraph csr(compact);
+	REQUIRE(csr.vertexCount() == 5);
+	REQUIRE(csr.edgeCount() == 5);
+	REQUIRE(!csr.hasVertices());
+	auto [components, sizes] = stronglyConnected(csr);
+	REQUIRE(components[0] == components[1]);
+	REQUIRE(components[0] == components[2]);
+	REQUIRE(components[3] != components[4]);
+
+	compact.removeEdge(a);
+	compact.removeEdge(a);
+	REQUIRE(compact.removed(a));
+	REQUIRE(compact.edgeCount() == 4);
+	compact.removeEdges(2);
+	REQUIRE(compact.removed(c));
+	REQUIRE(compact.edgeCount() == 1);
+	REQUIRE(compact.edgeIdCount() == 5);
+	size_t in = 0;
+	for (uint32_t vertex = 0; vertex < 5; vertex++) compact.forEachInEdge(vertex, [&in](uint32_t) { in++; });
+	REQUIRE(in == 1);
+	REQUIRE(compact.newEdge(4, 3, 6) == 5);
+	REQUIRE(CsrGraph(compact).inSources(3)[0] == 4);
+	REQUIRE_THROWS_AS(compact.removeEdge(6), std::out_of_range);
+	REQUIRE_THROWS_AS(compact.removeEdges(5), std::out_of_range);
+	REQUIRE_THROWS_AS(compact.addVertices(CompactGraph::none - 4), std::length_error);
+	REQUIRE(compact.vertexCount() == 5);
+
+	// Past one block of records, links across blocks stay intact
+	CompactGraph chain;
+	chain.addVertices(10000);
+	for (uint32_t v = 0; v + 1 < 10000; v++) chain.newEdge(v, v + 1, 1);
+	chain.removeEdges(5000);
+	REQUIRE(chain.edgeCount() == 9997);
+	REQUIRE(std::get<1>(weaklyConnected(CsrGraph(chain))).size() == 3);
+}
+
+TEST_CASE("test out degree", "Graph") {
+#ifndef GRAPH_INLINE_OUT_EDGES
+	static_assert(sizeof(Vertex) <= 64, "the out degree should fit in padding");
+#endif
+	Graph graph;
+	Vertex& hub = graph.newVertex();
+	auto targets = graph.addVertices(24);
+	// forEachOutEdge(0) sees the list in list order, inline or spilled
+	auto listed = [&hub]() {
+		std::vector<const Edge*> fromList, fromWalk;
+		for (const Edge& edge : hub.outEdges()) fromList.push_back(&edge);
+		hub.forEachOutEdge(0, [&fromWalk](const Edge& edge) { fromWalk.push_back(&edge); });
+		return fromList.size() == hub.outDegree() && fromList == fromWalk;
+	};
+	std::vector<Edge*> edges;
+	for (unsigned i = 0; i < 6; i++) {
+		edges.push_back(&graph.newEdge(hub, targets[i], i));
+		REQUIRE(listed());
+	}
+	graph.newEdge(hub, targets[7], 9, 2);
+	REQUIRE(hub.outDegree() == 6);
+	edges[0]->remove();
+	edges[3]->remove();
+	REQUIRE(hub.outDegree() == 4);
+	REQUIRE(listed());
+	edges[3]->remove();
+	REQUIRE(hub.outDegree() == 4);
+	edges[1]->remove();
+	REQUIRE(listed());
+	size_t all = 0;
+	hub.forEachOutEdge([&all](const Edge&) { all++; });
+	REQUIRE(all == 4);
+	for (unsigned i = 8; i < 24; i++) {
+		edges.push_back(&graph.newEdge(hub, targets[i], i));
+		REQUIRE(listed());
+	}
+	for (unsigned i = 6; i < 22; i += 2) {
+		edges[i]->remove();
+		REQUIRE(listed());
+	}
+	REQUIRE(hub.outDegree() == 11);
+	hub.removeEdges();
+	REQUIRE(hub.outDegree() == 0);
+	REQUIRE(listed());
+	graph.newEdge(hub, targets[0], 1);
+	REQUIRE(listed());
+
+	Graph bulk;
+	auto vertices = bulk.addVertices(64);
+	std::vector<EdgeSpec> specs;
+	for (unsigned i = 0; i < 64; i++)
+		for (unsigned j = 1; j <= i % 7; j++) specs.push_back({ vertices[i], vertices[(i + j) % 64], 1 });
+	bulk.addEdges(specs, 4);
+	for (const Vertex& vertex : bulk.vertices()) REQUIRE(vertex.outDegree() == vertex.id() % 7);
+	REQUIRE(graph::alg::CsrGraph(bulk).edgeCount() == specs.size());
+}
+
+TEST_CASE("test relayout", "Graph") {
+	using namespace graph::alg;
+	Graph graph;
+	auto vertices = graph::gen::layeredDag(graph, 10, 8, 3, 0.5);
+	graph.newEdge(*vertices[5], *vertices[9], 7, 2);
+	const CsrGraph before(graph, followAlwaysTrue, allLayers);
+	std::vector<std::pair<uint32_t, uint32_t>> edges;
+	for (uint32_t id = 0; id < before.vertexCount(); id++)
+		for (const uint32_t to : before.outTargets(id)) edges.emplace_back(id, to);
+
+	for (Layout layout : { Layout::Bfs, Layout::ReverseCuthillMcKee, Layout::Topological, Layout::SccGrouped }) {
+		std::vector<uint32_t> order = layoutOrder(CsrGraph(graph), layout);
+		std::vector<uint32_t> sorted = order;
+		std::sort(sorted.begin(), sorted.end());
+		for (uint32_t i = 0; i < sorted.size(); i++) REQUIRE(sorted[i] == i);
+		if (layout == Layout::Topological || layout == Layout::SccGrouped) {
+			std::vector<uint32_t> at(order.size());
+			for (uint32_t i = 0; i < order.size(); i++) at[order[i]] = i;
+			for (const auto& [from, to] : edges) REQUIRE(at[from] < at[to]);
+		}
+	}
+
+	AttributeStore store(graph);
+	auto& name = store.vertexColumn<uint32_t>("name");
+	for (uint32_t i = 0; i < name.size(); i++) name[i] = i;
+	auto& tag = store.edgeColumn<uint32_t>("tag");
+	std::vector<std::pair<uint32_t, uint32_t>> ends(tag.size());
+	for (const Vertex& vertex : graph.vertices())
+		vertex.forEachOutEdge([&](const Edge& edge) {
+			tag[edge.id()] = edge.id();
+			ends[edge.id()] = { edge.from().id(), edge.to().id() };
+		});
+	const Relayout layout = relayout(graph, Layout::Bfs);
+	const std::vector<Vertex*>& mapping = layout.vertices;
+	REQUIRE(mapping.size() == before.vertexCount());
+	REQUIRE(layout.edgeIds.size() == edges.size());
+	store.remap(layout);
+	for (uint32_t old = 0; old < mapping.size(); old++) {
+		REQUIRE(layout.vertexIds[old] == mapping[old]->id());
+		REQUIRE(store.vertexColumn<uint32_t>("name")[mapping[old]->id()] == old);
+	}
+	for (const Vertex& vertex : graph.vertices())
+		vertex.forEachOutEdge([&](const Edge& edge) {
+			const uint32_t old = store.edgeColumn<uint32_t>("tag")[edge.id()];
+			REQUIRE(layout.edgeIds[old] == edge.id());
+			REQUIRE(layout.vertexIds[ends[old].first] == edge.from().id());
+			REQUIRE(layout.vertexIds[ends[old].second] == edge.to().id());
+		});
+	uint32_t id = 0;
+	for (const Vertex& vertex : graph.vertices()) REQUIRE(vertex.id() == id++);
+	REQUIRE(graph.edgeIdCount() == edges.size());
+	std::vector<uint32_t> newOf(mapping.size());
+	for (uint32_t old = 0; old < mapping.size(); old++) newOf[old] = mapping[old]->id();
+	std::vector<std::pair<uint32_t, uint32_t>> moved;
+	const CsrGraph after(graph, followAlwaysTrue, allLayers);
+	for (const auto& [from, to] : edges) moved.emplace_back(newOf[from], newOf[to]);
+	std::vector<std::pair<uint32_t, uint32_t>> present;
+	for (uint32_t v = 0; v < after.vertexCount(); v++)
+		for (const uint32_t to : after.outTargets(v)) present.emplace_back(v, to);
+	std::sort(moved.begin(), moved.end());
+	std::sort(present.begin(), present.end());
+	REQUIRE(moved == present);
+	REQUIRE(mapping[5]->outEdges(2).front().weight() == 7);
+
+	// In list order is kept
+	Graph small;
+	auto abc = small.addVertices(3);
+	small.newEdge(abc[1], abc[2], 1);
+	small.newEdge(abc[0], abc[2], 2);
+	small.newEdge(abc[0], abc[1], 3).remove();
+	auto moved2 = small.relayout({ abc[2], abc[0], abc[1] }).vertices;
+	REQUIRE(moved2[2]->id() == 0);
+	REQUIRE(moved2[2]->inEdges().front().weight() == 1);
+	REQUIRE(moved2[2]->inEdges().back().weight() == 2);
+	REQUIRE_THROWS_AS(small.relayout({ *moved2[0], *moved2[0], *moved2[1] }), std::invalid_argument);
+	REQUIRE_THROWS_AS(small.relayout({ *moved2[0] }), std::invalid_argument);
+	REQUIRE_THROWS_AS(small.relayout({ *moved2[0], *moved2[1], *moved2[2], *moved2[0] }), std::invalid_argument);
+	Graph other;
+	Vertex& foreign = other.newVertex();
+	REQUIRE_THROWS_AS(small.relayout({ *moved2[0], *moved2[1], *moved2[2], foreign }), std::invalid_argument);
+	REQUIRE_THROWS_AS(small.relayout({ *moved2[0], *moved2[1], foreign }), std::invalid_argument);
+	REQUIRE(small.edgeIdCount() == 2);
+
+	Graph cycle;
+	auto ring = cycle.addVertices(3);
+	for (unsigned v = 0; v < 3; v++) cycle.newEdge(ring[v], ring[(v + 1) % 3], 1);
+	REQUIRE_THROWS_AS(layoutOrder(CsrGraph(cycle), Layout::Topological), std::invalid_argument);
+	REQUIRE(layoutOrder(CsrGraph(cycle), Layout::SccGrouped).size() == 3);
+}
@@ -0,0 +1,279 @@
+#include "writer.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+using graph::io::CsrGraph;
+using graph::io::DumpOptions;
+
+namespace dump
+{
+	// Buffered file output with integer formatting that does not allocate
+	class Output {
+		std::string m_path;
+		std::FILE* m_file;
+		char m_buffer[1 << 16];
+		size_t m_used = 0;
+
+		[[noreturn]] void fail(const char* what) const {
+			throw std::runtime_error("graph::io: " + m_path + ": " + what);
+		}
+
+	public:
+		explicit Output(const std::string& path)
+			: m_path(path)
+			, m_file(std::fopen(path.c_str(), "wb")) {
+			if (!m_file) fail("cannot create");
+		}
+		~Output() {
+			if (m_file) std::fclose(m_file);
+		}
+		Output(const Output&) = delete;
+		Output& operator=(const Output&) = delete;
+
+		void flush() {
+			if (m_used && std::fwrite(m_buffer, 1, m_used, m_file) != m_used) fail("write failed");
+			m_used = 0;
+		}
+		void close() {
+			flush();
+			const int result = std::fclose(m_file);
+			m_file = nullptr;
+			if (result != 0) fail("write failed");
+		}
+
+		Output& operator<<(char c) {
+			if (m_used == sizeof(m_buffer)) flush();
+			m_buffer[m_used++] = c;
+			return *this;
+		}
+		Output& operator<<(std::string_view text) {
+			while (!text.empty()) {
+				if (m_used == sizeof(m_buffer)) flush();
+				const size_t n = std::min(text.size(), sizeof(m_buffer) - m_used);
+				std::memcpy(m_buffer + m_used, text.data(), n);
+				m_used += n;
+				text.remove_prefix(n);
+			}
+			return *this;
+		}
+		Output& operator<<(const char* text) { return *this << std::string_view(text); }
+		template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+		Output& operator<<(T value) {
+			if (sizeof(m_buffer) - m_used < 24) flush();
+			m_used = std::to_chars(m_buffer + m_used, m_buffer + sizeof(m_buffer), value).ptr - m_buffer;
+			return *this;
+		}
+	};
+
+	bool keyword(std::string_view id) {
+		for (const char* word : { "node", "edge", "graph", "digraph", "subgraph", "strict" }) {
+			if (id.size() != std::strlen(word)) continue;
+			bool same = true;
+			for (size_t i = 0; i < id.size(); i++) same &= std::tolower(static_cast<unsigned char>(id[i])) == word[i];
+			if (same) return true;
+		}
+		return false;
+	}
+
+	void dotId(Output& out, const DumpOptions& options, uint32_t id) {
+		if (!options.names) {
+			out << 'n' << id;
+			return;
+		}
+		const std::string_view name = (*options.names)[id];
+		bool plain = !name.empty() && !std::isdigit(static_cast<unsigned char>(name[0])) && !keyword(name);
+		for (const char c : name) plain &= std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+		if (plain) {
+			out << name;
+			return;
+		}
+		out << '"';
+		for (const char c : name) {
+			if (c == '"' || c == '\\') out << '\\';
+			out << c;
+		}
+		out << '"';
+	}
+
+	void xmlText(Output& out, std::string_view text) {
+		for (const char c : text) {
+			switch (c) {
+			case '&': out << "&amp;"; break;
+			case '<': out << "&lt;"; break;
+			case '>': out << "&gt;"; break;
+			case '"': out << "&quot;"; break;
+			default: out << c;
+			}
+		}
+	}
+
+	void xmlId(Output& out, const DumpOptions& options, uint32_t id) {
+		if (options.names) xmlText(out, (*options.names)[id]);
+		else out << 'n' << id;
+	}
+
+	bool selected(const DumpOptions& options, uint32_t id) {
+		return !options.select || (*options.select)[id];
+	}
+
+	// Graphviz "set312" scheme colors are numbered from 1
+	uint32_t paletteColor(uint32_t color) { return color % 12 + 1; }
+
+	// Vertices are 0..count-1, edges(f) calls f(from, to, weight) for every edge in from order
+	template <typename F>
+	void writeDot(const std::string& path, uint32_t count, const DumpOptions& options, F&& edges)
+	{
+		Output out(path);
+		out << "digraph {\n";
+		if (options.color) out << "  node [colorscheme=set312, style=filled];\n";
+		for (uint32_t id = 0; id < count; id++) {
+			if (!selected(options, id)) continue;
+			out << "  ";
+			dotId(out, options, id);
+			if (options.color) out << " [fillcolor=" << paletteColor((*options.color)[id]) << ']';
+			out << ";\n";
+		}
+
+		if (options.rank) {
+			// Bucket the selected vertices by rank
+			const std::vector<uint32_t>& rank = *options.rank;
+			std::vector<uint32_t> start;
+			for (uint32_t id = 0; id < count; id++)
+				if (selected(options, id)) {
+					if (rank[id] + 2 > start.size()) start.resize(rank[id] + 2);
+					start[rank[id] + 1]++;
+				}
+			for (size_t r = 1; r < start.size(); r++) start[r] += start[r - 1];
+			std::vector<uint32_t> order(start.empty() ? 0 : start.back());
+			for (uint32_t id = 0; id < count; id++)
+				if (selected(options, id)) order[start[rank[id]]++] = id;
+			for (size_t r = 0, i = 0; i < order.size(); r++) {
+				if (i == start[r]) continue;
+				out << "  { rank=same;";
+				for (; i < start[r]; i++) {
+					out << ' ';
+					dotId(out, options, order[i]);
+					out << ';';
+				}
+				out << " }\n";
+			}
+		}
+
+		edges([&](uint32_t from, uint32_t to, int32_t weight) {
+			if (!selected(options, from) || !selected(options, to)) return;
+			out << "  ";
+			dotId(out, options, from);
+			out << " -> ";
+			dotId(out, options, to);
+			out << " [weight=" << weight << "];\n";
+		});
+		out << "}\n";
+		out.close();
+	}
+}
+
+namespace graph::io
+{
+	void writeDot(const std::string& path, const CsrGraph& csr, const DumpOptions& options)
+	{
+		dump::writeDot(path, csr.vertexCount(), options, [&csr](auto&& write) {
+			for (uint32_t from = 0; from < csr.vertexCount(); from++) {
+				const auto targets = csr.outTargets(from);
+				const auto weights = csr.outWeights(from);
+				for (size_t i = 0; i < targets.size(); i++) write(from, targets[i], weights[i]);
+			}
+		});
+	}
+
+	void writeDot(const std::string& path, const Graph& graph, const DumpOptions& options, EdgeFunc func)
+	{
+		// Position by vertex id, the id a CsrGraph of graph would give
+		std::vector<uint32_t> position(graph.vertexIdCount());
+		uint32_t count = 0;
+		for (const Vertex& vertex : graph.vertices()) position[vertex.id()] = count++;
+		dump::writeDot(path, count, options, [&](auto&& write) {
+			for (const Vertex& vertex : graph.vertices())
+				for (const Edge& edge : vertex.outEdges())
+					if (func(edge)) write(position[vertex.id()], position[edge.to().id()], edge.weight());
+		});
+	}
+
+	void writeGraphML(const std::string& path, const CsrGraph& csr, const DumpOptions& options)
+	{
+		dump::Output out(path);
+		out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+			"  <key id=\"weight\" for=\"edge\" attr.name=\"weight\" attr.type=\"int\"/>\n";
+		if (options.color) out << "  <key id=\"color\" for=\"node\" attr.name=\"color\" attr.type=\"int\"/>\n";
+		if (options.rank) out << "  <key id=\"rank\" for=\"node\" attr.name=\"rank\" attr.type=\"int\"/>\n";
+		out << "  <graph edgedefault=\"directed\">\n";
+		for (uint32_t id = 0; id < csr.vertexCount(); id++) {
+			if (!dump::selected(options, id)) continue;
+			out << "    <node id=\"";
+			dump::xmlId(out, options, id);
+			if (!options.color && !options.rank) {
+				out << "\"/>\n";
+				continue;
+			}
+			out << "\">";
+			if (options.color) out << "<data key=\"color\">" << (*options.color)[id] << "</data>";
+			if (options.rank) out << "<data key=\"rank\">" << (*options.rank)[id] << "</data>";
+			out << "</node>\n";
+		}
+		for (uint32_t from = 0; from < csr.vertexCount(); from++) {
+			if (!dump::selected(options, from)) continue;
+			const auto targets = csr.outTargets(from);
+			const auto weights = csr.outWeights(from);
+			for (size_t i = 0; i < targets.size(); i++) {
+				if (!dump::selected(options, targets[i])) continue;
+				out << "    <edge source=\"";
+				dump::xmlId(out, options, from);
+				out << "\" target=\"";
+				dump::xmlId(out, options, targets[i]);
+				out << "\"><data key=\"weight\">" << weights[i] << "</data></edge>\n";
+			}
+		}
+		out << "  </graph>\n</graphml>\n";
+		out.close();
+	}
+
+	std::vector<bool> selectComponent(const std::vector<uint32_t>& components, uint32_t component)
+	{
+		std::vector<bool> select(components.size());
+		for (size_t id = 0; id < components.size(); id++) select[id] = components[id] == component;
+		return select;
+	}
+
+	std::vector<bool> selectNeighborhood(const CsrGraph& csr, const std::vector<uint32_t>& roots, uint32_t hops)
+	{
+		std::vector<bool> select(csr.vertexCount());
+		std::vector<uint32_t> frontier, next;
+		for (const uint32_t root : roots)
+			if (!select[root]) {
+				select[root] = true;
+				frontier.push_back(root);
+			}
+		for (uint32_t hop = 0; hop < hops && !frontier.empty(); hop++) {
+			for (const uint32_t id : frontier) {
+				for (const uint32_t to : csr.outTargets(id))
+					if (!select[to]) {
+						select[to] = true;
+						next.push_back(to);
+					}
+				for (const uint32_t from : csr.inSources(id))
+					if (!select[from]) {
+						select[from] = true;
+						next.push_back(from);
+					}
+			}
+			frontier.swap(next);
+			next.clear();
+		}
+		return select;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "csr.hpp"
+
+#include <string>
+#include <vector>
+namespace graph::io
+{
+	using namespace graph::core;
+	using graph::alg::CsrGraph;
+
+	// Optional annotations and filter for the text writers, all indexed by CsrGraph id
+	struct DumpOptions {
+		const std::vector<std::string>* names = nullptr;  // Defaults to "n<id>"
+		const std::vector<uint32_t>* color = nullptr;  // Class of each vertex, e.g. a component id, mapped to a palette
+		const std::vector<uint32_t>* rank = nullptr;  // DOT draws vertices of equal rank on one row
+		const std::vector<bool>* select = nullptr;  // Only selected vertices and the edges between them are written
+	};
+
+	// Text is formatted into a fixed buffer and streamed out, nothing proportional to the
+	// graph is allocated apart from the rank buckets. Edge weights are written as "weight"
+	// attributes, so readDot() reads the output back. Throws std::runtime_error on I/O failure.
+	// The Graph overload streams straight from the lists, numbering vertices in an array indexed
+	// by Vertex::id(); its ids are those a CsrGraph of the followed layer 0 edges would have.
+	void writeDot(const std::string& path, const CsrGraph& csr, const DumpOptions& options = {});
+	void writeDot(const std::string& path, const Graph& graph, const DumpOptions& options = {}, EdgeFunc func = graph::alg::followAlwaysTrue);
+	void writeGraphML(const std::string& path, const CsrGraph& csr, const DumpOptions& options = {});
+
+	// Selections for DumpOptions::select
+	std::vector<bool> selectComponent(const std::vector<uint32_t>& components, uint32_t component);
+	std::vector<bool> selectNeighborhood(const CsrGraph& csr, const std::vector<uint32_t>& roots, uint32_t hops);  // Edges are followed both ways
+}